@@ -0,0 +1,163 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "minirel.h"
+#include "Iterator.h"
+
+#define BATCH_SIZE 1024 // Max # of tuples in a batch
+
+
+// A batch of up to BATCH_SIZE tuples of an all-integer relation, stored
+// column-wise. Only the tuples listed in the selection vector are part of
+// the batch; filters drop tuples by shrinking it instead of moving data.
+class Batch {
+public:
+	Batch(int numOfAttr);
+	~Batch();
+
+	// Returns the values of attribute attr, indexed by tuple position.
+	int* Column(int attr) { return cols + attr * BATCH_SIZE; }
+
+	// Selects every tuple in the columns.
+	void SelectAll();
+
+	int numOfAttr;
+	int numOfTuples; // # of tuples stored in the columns
+	int *sel;        // positions of the selected tuples, in order
+	int numOfSel;    // # of entries in sel
+
+private:
+	int *cols;
+};
+
+
+// Base class for operators exchanging batches. The protocol is the same as
+// for Iterator: Open, Next until DONE, then Close. The batch returned by
+// Next belongs to the operator and stays valid until the next call to Next
+// or Close. A batch returned with OK has at least one selected tuple.
+class BatchIterator {
+public:
+	virtual ~BatchIterator() {}
+
+	virtual Status Open() = 0;
+	virtual Status Next(Batch*& batch) = 0;
+	virtual Status Close() = 0;
+
+	// # of attributes of the tuples produced by this operator.
+	int GetNumOfAttr() { return numOfAttr; }
+
+protected:
+	int numOfAttr;
+};
+
+
+// Groups the records produced by a tuple iterator into batches. When the
+// child scans a HeapFile, the file is read a page at a time instead, in
+// the order HeapFileIterator would use for the child's hint.
+class ScanBatchIterator : public BatchIterator {
+public:
+	ScanBatchIterator(Iterator* child);
+	~ScanBatchIterator();
+
+	Status Open();
+	Status Next(Batch*& batch);
+	Status Close();
+
+private:
+	Iterator *child;
+	Batch *batch;
+
+	HeapFileScan *scan; // scan of the child's file, if it has one
+	char **pageRecs;    // records of the current page not yet in a batch
+	int pageCount;
+	int pagePos;
+	int numOfScans;     // # of scans since the file proved larger than the pool
+	int numOfPages;     // most data pages seen by a single scan
+
+	Status NextFromPages(int& n);
+	Status NextFromChild(int& n);
+};
+
+
+// Returns the tuples of its child whose attribute attr satisfies
+// <attr op value>.
+class FilterBatchIterator : public BatchIterator {
+public:
+	FilterBatchIterator(BatchIterator* child, int attr, AttrOperator op, int value);
+	~FilterBatchIterator();
+
+	Status Open();
+	Status Next(Batch*& batch);
+	Status Close();
+
+private:
+	BatchIterator *child;
+	int attr;
+	AttrOperator op;
+	int value;
+};
+
+
+// Block nested loops equijoin over batches. Up to blockSize outer tuples are
+// buffered column-wise, then every inner batch is compared with the whole
+// block. Output tuples are <left, right>, so swapped must be true when the
+// outer input is the right relation.
+class BatchJoinIterator : public BatchIterator {
+public:
+	BatchJoinIterator(BatchIterator* outer, BatchIterator* inner,
+		              int outerAttr, int innerAttr, bool swapped, int blockSize);
+	~BatchJoinIterator();
+
+	Status Open();
+	Status Next(Batch*& batch);
+	Status Close();
+
+private:
+	BatchIterator *outer;
+	BatchIterator *inner;
+	int outerAttr;
+	int innerAttr;
+	bool swapped;
+
+	int blockSize;
+	int *block;        // blockSize outer tuples, one column after the other
+	int blockCount;    // # of tuples currently in block
+	bool outerDone;
+	Batch *outerBatch; // outer batch being copied into block
+	int outerBatchPos; // next entry of outerBatch->sel to copy
+
+	bool innerOpen;
+	Batch *innerBatch; // current inner batch, or NULL
+	int *innerKeys;    // join attribute of the selected inner tuples
+	int numOfInner;    // # of entries in innerKeys
+	int probePos;      // next block tuple to compare with innerBatch
+
+	Batch *out;
+	int *outerIdx;     // block position of each output tuple
+	int *innerIdx;     // innerBatch position of each output tuple
+
+	Status FillBlock();
+	void Probe();
+	void Gather();
+};
+
+
+// Returns the tuples of a batch operator one record at a time, so that
+// batch plans can be consumed by Materialize or fed to tuple iterators.
+class BatchToRowIterator : public Iterator {
+public:
+	BatchToRowIterator(BatchIterator* child);
+	~BatchToRowIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+
+private:
+	BatchIterator *child;
+	Batch *batch;
+	int pos;
+	char *rec;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _BLOOM_FILTER_H_
+#define _BLOOM_FILTER_H_
+
+#include <iostream>
+#include "minirel.h"
+
+#define BLOOM_BITS_PER_KEY 16 // bits of filter per key it is sized for
+#define BLOOM_BITS_PER_WORD 4 // bits set per key
+
+
+// A Bloom filter over integer join keys, built from one input of a join
+// and probed with the keys of the other to drop tuples that can't match
+// before the join does any real work for them.
+//
+// The filter is register-blocked: all the bits of a key lie in one 64-bit
+// word, chosen by the hash of the key, so adding or probing a key reads
+// one word (one cache line) and tests it with a single mask. This costs a
+// slightly higher false positive rate than spreading the bits over the
+// whole filter, about 1% at BLOOM_BITS_PER_KEY.
+//
+// The filter also keeps the range of the keys added. Keys outside it are
+// rejected by two comparisons, before any hashing, and the range tells the
+// other input where matches can stop.
+//
+// Every probe of every filter is counted, so that the fraction of probe
+// tuples passed on to the join can be reported.
+class BloomFilter {
+public:
+	// A filter sized for numOfKeys keys. More keys can be added, at the
+	// cost of more false positives.
+	BloomFilter(int numOfKeys);
+	~BloomFilter();
+
+	void Add(int key);
+
+	// False if key was never added; true if it was, or by chance.
+	bool MayContain(int key);
+
+	// Removes all keys.
+	void Clear();
+
+	// Sets min and max to the smallest and largest key added. Returns
+	// false if no key was added.
+	bool GetRange(int& min, int& max);
+
+	// # of probes of all filters, and # of them that passed, since the
+	// last ResetStat.
+	static void GetStat(long& probes, long& passes);
+	static void ResetStat();
+	static void PrintStat(std::ostream& out);
+
+private:
+	unsigned long long *words;
+	unsigned int mask;  // # of words - 1, which is a power of 2
+	int numOfKeys;      // # of keys added
+	int minKey;
+	int maxKey;
+
+	static long numOfProbes;
+	static long numOfPasses;
+
+	static unsigned long long Hash(int key);
+	unsigned long long KeyBits(unsigned long long hash);
+};
+
+#endif
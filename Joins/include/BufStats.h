@@ -0,0 +1,45 @@
+#ifndef _BUF_STATS_H_
+#define _BUF_STATS_H_
+
+#include <iostream>
+#include "minirel.h"
+
+#define MAX_STAT_ENTRIES 32 // # of distinct names that can be counted
+#define MAX_STAT_DEPTH 16   // # of nested scopes
+
+
+// Breaks the pins and misses reported by BufMgr::GetStat down by the part
+// of the code that caused them. Code enters a named scope before the work
+// and leaves it afterwards; the pins and misses in between are charged to
+// the innermost scope only, so a scope nested in another (e.g. sorting
+// inside SortMerge) is not counted twice. Pages read outside the buffer
+// pool, by ring scans, are counted as reads. Entries accumulate until
+// Reset is called.
+class BufStats {
+public:
+	static void Enter(const char* name);
+	static void Leave();
+
+	// Adds numOfPages page reads that bypassed the buffer pool.
+	static void AddReads(int numOfPages);
+
+	// Returns false if nothing was charged to name.
+	static bool Get(const char* name, long& pins, long& misses, long& reads);
+
+	static void Print(std::ostream& out);
+	static void Reset();
+
+private:
+	static int Find(const char* name);
+	static void Charge();
+};
+
+
+// Enters a BufStats scope for the lifetime of the object.
+class BufStatsScope {
+public:
+	BufStatsScope(const char* name) { BufStats::Enter(name); }
+	~BufStatsScope() { BufStats::Leave(); }
+};
+
+#endif
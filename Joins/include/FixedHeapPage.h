@@ -0,0 +1,64 @@
+#ifndef _FIXED_HEAPPAGE_H_
+#define _FIXED_HEAPPAGE_H_
+
+#include "minirel.h"
+#include "heappage.h"
+
+// Values of HeapPage::type telling readers how a data page is laid out.
+// HeapPage::Init leaves type as it finds it, so type is only meaningful on
+// the pages whose directory entry holds FORMATTED_PAGE_SPACE; every other
+// page is a HeapPage.
+#define SLOTTED_PAGE_TYPE 0      // HeapPage, records addressed by slots
+#define FIXED_PAGE_TYPE 0x4658   // FixedHeapPage
+
+// PageInfo::spaceAvailable of a page HeapFileWriter filled in a format
+// other than HeapPage. The library never stores a negative amount of space
+// this large, and HeapFile::InsertRecord never picks such a page.
+#define FORMATTED_PAGE_SPACE (-0x7FFF)
+
+
+// A data page holding records of one fixed length. Instead of a slot per
+// record, the start of the data area holds a bitmap with one bit per
+// record position, and record i is stored at i * recLen after it. This
+// fits more records on a page than HeapPage and finds a record with a
+// single multiply.
+//
+// The page has the same size and header as HeapPage, so the directory
+// and the buffer manager handle it like any data page; the header fields
+// are reused as follows:
+//   type       - FIXED_PAGE_TYPE
+//   freePtr    - the record length
+//   freeSpace  - the # of record positions on the page
+//   numOfSlots - the # of positions used so far; records are appended
+//
+// HeapPage's own methods don't understand this layout. Pages must be
+// written with HeapFileWriter and read with HeapFileScan.
+class FixedHeapPage : public HeapPage {
+public:
+	// Initializes the page for records of length recLen.
+	void Init(PageID pageNo, int recLen);
+
+	Status InsertRecord(const char* recPtr, int recLen, RecordID& rid);
+	Status DeleteRecord(RecordID rid);
+	Status ReturnRecord(RecordID rid, char*& recPtr, int& len);
+
+	// Space left for new records, a multiple of the record length.
+	int AvailableSpace() { return (freeSpace - numOfSlots) * freePtr; }
+	int GetNumOfRecords();
+
+	int GetRecLen() { return freePtr; }
+
+	// # of record positions used so far, whether or not deleted since.
+	int GetNumOfPositions() { return numOfSlots; }
+
+	bool IsUsed(int pos) { return ((data[pos >> 3] >> (pos & 7)) & 1) != 0; }
+	char* GetRecordPointer(int pos) { return data + BitmapSize() + pos * freePtr; }
+
+	// # of records of length recLen that fit on a page.
+	static int Capacity(int recLen);
+
+private:
+	int BitmapSize() { return (freeSpace + 7) / 8; }
+};
+
+#endif
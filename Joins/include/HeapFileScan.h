@@ -0,0 +1,149 @@
+#ifndef _HEAPFILE_SCAN_H_
+#define _HEAPFILE_SCAN_H_
+
+#include "minirel.h"
+#include "heapfile.h"
+#include "dirpage.h"
+#include "heappage.h"
+#include "ZoneMap.h"
+
+// Upper bound on the # of records on a HeapPage (one slot per record).
+#define MAX_RECORDS_PER_PAGE (HEAPPAGE_DATA_SIZE / (2 * sizeof(short)))
+
+// # of data pages the scan pins ahead of the page it is reading.
+#define READ_AHEAD_PAGES (MINIBASE_IO_UNIT / MINIBASE_PAGESIZE)
+
+
+// Scans the records of a HeapFile without copying them. Like Scan, it walks
+// the directory entries and keeps the current directory page and data page
+// pinned. When it moves to a data page it collects pointers to all records
+// on the page in one pass over the slot array; GetNext then returns them one
+// at a time and NextPage all at once. Record pointers point into the pinned
+// page and stay valid until the scan moves to another page, i.e. until a
+// later call returns records from a different page, or the scan is deleted.
+// Callers must not modify the records. FixedHeapPages, PaxHeapPages and
+// PackedHeapPages are read as well, if their directory entries say so; the
+// records of the latter two are gathered, or decoded, into a buffer of the
+// scan only when a caller asks for whole records.
+//
+// Data pages are pinned READ_AHEAD_PAGES at a time, in ascending PageID
+// order, so that the misses of a sequential scan reach the disk as runs of
+// consecutive reads instead of being interleaved with other work.
+//
+// A backward scan visits the data pages from the last directory entry to
+// the first. Records within a page are still returned in slot order.
+//
+// A one-pass scan of a large file can use a ring instead: the data pages
+// are then read from the database into READ_AHEAD_PAGES frames owned by
+// the scan, and leave the pages cached in the buffer pool where they are.
+// Dirty pages are flushed when the scan is created, so the file must not
+// be modified while a ring scan is open.
+//
+// Given a ZoneMap of the file and a key range, the scan skips the data
+// pages the map knows to hold no key in the range. They are dropped while
+// the directory is read, so they are never pinned.
+class HeapFileScan {
+public:
+	HeapFileScan(HeapFile* file, Status& status, bool backward = false,
+		         bool useRing = false);
+	~HeapFileScan();
+
+	Status GetNext(RecordID& rid, char*& recPtr, int& recLen);
+
+	// Returns the records of the current page not yet returned by GetNext,
+	// or all records of the next non-empty page. recPtrs and rids point to
+	// arrays owned by the scan, valid until the scan moves to another page.
+	Status NextPage(char**& recPtrs, RecordID*& rids, int& numOfRecs);
+
+	// Like NextPage, but returns only the integer attribute at offset of
+	// each record. The keys of a PaxHeapPage are returned in place, and only
+	// the key column of a PackedHeapPage is decoded.
+	Status NextPageKeys(int offset, int*& keys, RecordID*& rids, int& numOfRecs);
+
+	// Skips the data pages that zones knows to hold no record whose key
+	// lies in [low, high]. Other records of the pages read are still
+	// returned. Takes effect with the next pages read ahead, and may be
+	// called again to narrow or move the range.
+	void SetKeyRange(ZoneMap* zones, int low, int high);
+
+	// Records the key range of every data page the scan reads in zones.
+	void BuildZoneMap(ZoneMap* zones);
+
+	// Change the position of the scan right *before* rid, i.e. the next
+	// GetNext() call will return the record with RecordID rid.
+	Status MoveTo(RecordID rid);
+
+	// True if file has more data pages than the buffer pool has frames,
+	// i.e. a scan should use a ring.
+	static bool ExceedsPool(HeapFile* file);
+
+	// Returns a pointer to record rid on a pinned data page of any format.
+	// Records of a PaxHeapPage or PackedHeapPage are copied into buf first,
+	// which must have room for one record. Unless formatted is true, the
+	// page is read as a HeapPage.
+	static Status ReturnRecord(HeapPage* page, RecordID rid, char*& recPtr, int& len,
+		                       char* buf, bool formatted);
+
+	// True once the scan has come across a page that is not a HeapPage.
+	// HeapFileWriter formats all pages of a file alike, so after a full
+	// scan this tells how to read any page of the file.
+	bool HasFormattedPages() { return formattedFile; }
+
+	// Counts the data pages of file by walking its directory.
+	static int CountPages(HeapFile* file);
+
+	// # of data pages with records the scan has moved to so far.
+	int GetNumOfPagesRead() { return numOfPagesRead; }
+
+private:
+	HeapFile *file;
+
+	PageID dirPid;       // current directory page, pinned
+	DirPage *dirPage;
+	int currEntry;       // next entry of dirPage to visit
+	bool backward;
+
+	PageID ahead[READ_AHEAD_PAGES];          // next data pages, pinned
+	HeapPage *aheadPages[READ_AHEAD_PAGES];
+	bool aheadFormatted[READ_AHEAD_PAGES];   // true if not a HeapPage
+	int aheadCount;
+	int aheadPos;        // next entry of ahead to read
+
+	PageID currPid;      // current data page, pinned
+	HeapPage *page;
+	short pageType;      // layout of page, SLOTTED_PAGE_TYPE if unmarked
+	bool formattedFile;  // true once a page was not a HeapPage
+
+	char **recs;         // the records on page, in slot order
+	short *lens;
+	RecordID *rids;
+	int numOfRecs;
+	bool rowsLoaded;     // false until recs is set for a column-wise page
+	char *rows;          // the records of a column-wise page, gathered
+	int rowsSize;
+	int *keys;           // keys returned by NextPageKeys
+	int pos;             // next entry of recs to return
+	bool noMore;
+	int numOfPagesRead;
+
+	Page *ring;          // frames of a ring scan, NULL if it uses the pool
+
+	ZoneMap *zones;      // ranges to skip pages by, or to fill, or NULL
+	bool buildZones;
+	int keyLow;          // key range of the records wanted
+	int keyHigh;
+
+	Status NextDataPage();
+	Status ReadAhead();
+	void DropReadAhead();
+	Status FetchPage(PageID pid, int frame, HeapPage*& dataPage);
+	Status ReleasePage(PageID pid);
+	Status PinDataPage(PageID pid, bool formatted);
+	void LoadPage();
+	void LoadRows();
+	int* PageKeys(int offset);
+	void Release();
+	static short PageType(HeapPage* page, bool formatted);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _HEAPFILE_WRITER_H_
+#define _HEAPFILE_WRITER_H_
+
+#include "minirel.h"
+#include "heapfile.h"
+#include "dirpage.h"
+#include "heappage.h"
+#include "FixedHeapPage.h"
+#include "PaxHeapPage.h"
+#include "PackedHeapPage.h"
+#include "ZoneMap.h"
+
+// # of data pages released at a time, and in the first extent
+#define WRITER_RUN_SIZE (MINIBASE_IO_UNIT / MINIBASE_PAGESIZE)
+
+// Max # of contiguous data pages allocated at a time, 8 I/O units
+#define WRITER_MAX_EXTENT (8 * WRITER_RUN_SIZE)
+
+// Layouts the writer can give the data pages it fills.
+enum PageFormat {
+	SLOTTED_PAGES, // HeapPage
+	FIXED_PAGES,   // FixedHeapPage
+	PAX_PAGES,     // PaxHeapPage, integer attributes only
+	PACKED_PAGES   // PackedHeapPage, integer attributes only
+};
+
+
+// Appends records to the end of a HeapFile. Unlike HeapFile::InsertRecord,
+// which searches the directory for free space and pins the target page for
+// every record, the writer keeps the page being filled and the last
+// directory page pinned, allocates data pages in extents of contiguous
+// pages, and enters each data page into the directory once, when it is
+// full. Extents start at WRITER_RUN_SIZE pages and double up to
+// WRITER_MAX_EXTENT, so small temp files stay small while large ones are
+// laid out in long sequential runs. The file should not be modified
+// through other means until the writer is closed.
+//
+// Full data pages stay pinned until WRITER_RUN_SIZE of them are finished,
+// then are released together in ascending PageID order. They are written
+// back only when evicted, and since the pool evicts them in the order they
+// were released, the writes of a file larger than the pool reach the disk
+// in runs of consecutive pages. Temp files deleted before they are evicted
+// are never written.
+//
+// When all records have the same length, the writer can fill FixedHeapPages
+// or PaxHeapPages instead of HeapPages. The length of the first record
+// appended is then the length of all of them. Such files must be empty
+// when the writer is created, must be read with HeapFileScan, and must not
+// be modified through HeapFile. The directory entry of each of their pages
+// is marked with FORMATTED_PAGE_SPACE. For PackedHeapPages the records of the current page are
+// kept by the writer until the page is full, since the page can only be
+// compressed once all its values are known.
+class HeapFileWriter {
+public:
+	HeapFileWriter(HeapFile* file, Status& status, PageFormat format = SLOTTED_PAGES);
+	~HeapFileWriter();
+
+	Status Append(const char* recPtr, int recLen, RecordID& outRid);
+	Status Append(const char* recPtr, int recLen);
+
+	// Records the key range of every data page the writer finishes from
+	// now on in zones.
+	void SetZoneMap(ZoneMap* zones) { this->zones = zones; }
+
+	// # of records and data pages this writer added to the file.
+	int GetNumOfRecords() { return numOfRecords; }
+	int GetNumOfPages() { return numOfPages; }
+
+	// Enters the last page into the directory and releases all pinned and
+	// unused pages. Called by the destructor if needed.
+	Status Close();
+
+private:
+	HeapFile *file;
+	PageFormat format;
+	int recLen;           // length of the records if not slotted, 0 until known
+
+	PageID dirPid;        // last directory page, pinned
+	DirPage *dirPage;
+
+	PageID currPid;       // data page being filled, pinned
+	HeapPage *currPage;
+	int currRecords;      // # of records on currPage
+	int numOfRecords;
+	int numOfPages;
+
+	PageID nextPid;       // allocated pages that are not used yet
+	int numOfFreePages;
+	int extentSize;       // # of pages to allocate next
+
+	PageID dirtyPids[WRITER_RUN_SIZE]; // finished pages, pinned
+	int numOfDirty;
+
+	int *packRows;        // records of currPage if PACKED_PAGES
+	int *packMin;         // smallest and largest value of each attribute
+	int *packMax;         // in packRows
+	int *packWidths;
+
+	ZoneMap *zones;       // NULL if none is maintained
+	int keyMin;           // key range of the records on currPage
+	int keyMax;
+
+	Status NextDataPage();
+	Status FinishPage();
+	Status ReleaseDirty();
+	int AvailableSpace();
+	Status AppendPacked(const char* recPtr, RecordID& outRid);
+	bool PackFits(const char* recPtr);
+	void AddKey(const char* recPtr);
+};
+
+#endif
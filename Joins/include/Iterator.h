@@ -0,0 +1,136 @@
+#ifndef _ITERATOR_H_
+#define _ITERATOR_H_
+
+#include "minirel.h"
+#include "heapfile.h"
+#include "HeapFileScan.h"
+
+// How a consumer reads an iterator. Scans of stored relations use it to
+// decide the order in which they visit the pages of the file.
+enum AccessHint {
+	SEQUENTIAL_ONCE, // opened once and read from start to end
+	CYCLIC           // reopened and read in full over and over
+};
+
+
+// Base class for pipelined (Volcano-style) operators. A consumer calls Open
+// once, then Next until it returns DONE, then Close. An iterator may be
+// opened again after it has been closed, which restarts it from the
+// beginning. Iterators own their children and delete them when destroyed.
+class Iterator {
+public:
+	Iterator() { hint = SEQUENTIAL_ONCE; }
+	virtual ~Iterator() {}
+
+	// Prepares the iterator to produce its first record.
+	virtual Status Open() = 0;
+
+	// Returns OK and sets recPtr to the next record, DONE when there are no
+	// more records and FAIL on error. recPtr points to memory owned by the
+	// iterator and stays valid until the next call to Next or Close.
+	virtual Status Next(char*& recPtr) = 0;
+
+	// Releases the resources acquired by Open.
+	virtual Status Close() = 0;
+
+	// Returns the HeapFile this iterator scans, or NULL if the records are
+	// computed on the fly.
+	virtual HeapFile* GetFile() { return NULL; }
+
+	// Length of the records produced by this iterator.
+	int GetRecLen() { return recLen; }
+
+	// Tells the iterator how it will be read. Must be called before the
+	// first Open. Operators pass the hint on to the child they read from.
+	virtual void SetHint(AccessHint hint) { this->hint = hint; }
+	AccessHint GetHint() { return hint; }
+
+	// Tells the iterator that, until the next call, the consumer only needs
+	// the records whose integer attribute at offset lies in [low, high].
+	// The iterator may use it to skip work, but may still return other
+	// records. Takes effect at the next Open.
+	virtual void SetKeyRange(int /*offset*/, int /*low*/, int /*high*/) {}
+
+	// Tells the iterator that the consumer needs every record again, as
+	// before the first SetKeyRange. Takes effect at the next Open.
+	virtual void ClearKeyRange() {}
+
+protected:
+	int recLen;
+	AccessHint hint;
+};
+
+
+// Scans all the records of a HeapFile. Records are returned in place,
+// without being copied out of the buffer pool. With the CYCLIC hint, once
+// a scan has shown that the file does not fit in the buffer pool, every
+// other scan runs backward, so each rescan starts with the pages the
+// previous one left in the pool instead of those it evicted first. Once a
+// key range is set, rescans skip the pages a zone map rules out.
+class HeapFileIterator : public Iterator {
+public:
+	HeapFileIterator(HeapFile* file, int recLen);
+	~HeapFileIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+	HeapFile* GetFile() { return file; }
+	void SetKeyRange(int offset, int low, int high);
+	void ClearKeyRange();
+
+private:
+	HeapFile *file;
+	HeapFileScan *scan;
+	int numOfScans; // # of scans since the file proved larger than the pool
+	int numOfPages; // most data pages seen by a single scan
+
+	ZoneMap *zones;     // key range of each page, once a key range is set
+	bool zonesComplete; // true once a scan has filled zones
+	int keyLow;
+	int keyHigh;
+};
+
+
+// Returns the records of its child whose integer attribute at offset
+// satisfies <attr op value>.
+class FilterIterator : public Iterator {
+public:
+	FilterIterator(Iterator* child, int offset, AttrOperator op, int value);
+	~FilterIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+	void SetHint(AccessHint hint) { child->SetHint(hint); }
+	void SetKeyRange(int offset, int low, int high) { child->SetKeyRange(offset, low, high); }
+	void ClearKeyRange() { child->ClearKeyRange(); }
+
+private:
+	Iterator *child;
+	int offset;
+	AttrOperator op;
+	int value;
+};
+
+
+// Projects the records of its child, which must consist of integer
+// attributes, onto the attributes listed in attrs.
+class ProjectIterator : public Iterator {
+public:
+	ProjectIterator(Iterator* child, int numOfAttr, const int* attrs);
+	~ProjectIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+	void SetHint(AccessHint hint) { child->SetHint(hint); }
+
+private:
+	Iterator *child;
+	int numOfAttr;
+	int *attrs;
+	char *rec;
+};
+
+#endif
@@ -3,10 +3,17 @@
 
 #include "minirel.h"
 #include "heapfile.h"
+#include "Iterator.h"
+#include "Batch.h"
+#include "BufStats.h"
+#include "BloomFilter.h"
+#include "HeapFileWriter.h"
 
 #define MAX_REL_NAME_LENGTH 32 // MAX relation name length
 #define MAX_ATTR 10 // Max # of attributes
 
+class BTreeFile;
+class BTreeFileScan;
 
 
 // Representnts a relation for to join. 
@@ -29,6 +36,18 @@ struct JoinSpec {
 	// offset: the offset of join attribute from the beginning of record
 	int offset; 
 
+	// # of records and data pages in file, -1 until known. Whoever 
+	// modifies the file must reset them. 
+	int numOfRecords;
+	int numOfPages;
+
+	JoinSpec() { file = NULL; numOfRecords = -1; numOfPages = -1; }
+
+	// Return the counts above, computing them from the file the first 
+	// time they are needed. 
+	int GetNumOfRecords();
+	int GetNumOfPages();
+
 	void PrintRelation(const char* filename = NULL);
 };
 
@@ -38,15 +57,54 @@ class JoinMethod {
 
 
 public:		
+	virtual ~JoinMethod() {}
+
 	// Static methods that may be useful for implementing other join methods.
 	static void toString(const int n, char* str, int pad = 8);
 	static void MakeNewRecord(char* newRec, char* leftRec, char* rightRec, 
 		                      JoinSpec& leftSpec, JoinSpec& rightSpec);
-	static HeapFile* SortHeapFile(HeapFile *file, int len, int offset);
+	static HeapFile* SortHeapFile(HeapFile *file, int len, int offset, ZoneMap *zones = NULL,
+		                          BloomFilter *build = NULL, BloomFilter *probe = NULL);
+	static Status Materialize(Iterator* it, JoinSpec& out, PageFormat format = SLOTTED_PAGES);
 
 public:
-	// Virtual method that all derived classes should implement. 
+	// Virtual method that all derived classes should implement. The result
+	// in out.file is stored on HeapPages, readable by any HeapFile method.
 	virtual Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+
+	// Returns a pipelined iterator over the join of left and right. The 
+	// caller owns the iterator. 
+	Iterator* CreateIterator(JoinSpec& left, JoinSpec& right);
+
+	// Returns a pipelined iterator joining the records produced by left and
+	// right, which are described by leftSpec and rightSpec. The iterator 
+	// takes ownership of its inputs. A spec whose file is NULL describes a
+	// computed input, such as the output of another join. 
+	virtual Iterator* Pipeline(Iterator* left, Iterator* right, 
+		                       JoinSpec& leftSpec, JoinSpec& rightSpec) = 0;
+};
+
+
+// Base class for the pipelined versions of the join methods. The outer 
+// input is scanned once; the inner input may be opened several times. 
+// Output tuples are always <left, right>, so swapped must be true when
+// the outer input is the right relation. 
+class JoinIterator : public Iterator {
+public:
+	JoinIterator(Iterator* outer, Iterator* inner, 
+		         JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped);
+	virtual ~JoinIterator();
+
+protected:
+	Iterator *outer;
+	Iterator *inner;
+	JoinSpec outerSpec;
+	JoinSpec innerSpec;
+	bool swapped;
+	char *outRec;
+
+	char* Join(char* outerRec, char* innerRec);
+	static HeapFile* InputFile(Iterator* input, JoinSpec& spec, HeapFile*& tmp);
 };
 
 
@@ -57,6 +115,8 @@ public:
 class TupleNestedLoops : public JoinMethod {
 public:
 	Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+	Iterator* Pipeline(Iterator* left, Iterator* right, 
+		               JoinSpec& leftSpec, JoinSpec& rightSpec);
 };
 
 class BlockNestedLoops : public JoinMethod {
@@ -65,16 +125,142 @@ public:
 	BlockNestedLoops(int _blockSize = 100) { blockSize = _blockSize; }
 
 	Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+	Iterator* Pipeline(Iterator* left, Iterator* right, 
+		               JoinSpec& leftSpec, JoinSpec& rightSpec);
 };
 
 class IndexNestedLoops : public JoinMethod {
 public:
 	Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+	Iterator* Pipeline(Iterator* left, Iterator* right, 
+		               JoinSpec& leftSpec, JoinSpec& rightSpec);
 };
 
 class SortMerge : public JoinMethod {
 public:
 	Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+	Iterator* Pipeline(Iterator* left, Iterator* right, 
+		               JoinSpec& leftSpec, JoinSpec& rightSpec);
+};
+
+class BatchNestedLoops : public JoinMethod {
+public:
+	int blockSize;
+	BatchNestedLoops(int _blockSize = BATCH_SIZE) { blockSize = _blockSize; }
+
+	Status Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out);
+	Iterator* Pipeline(Iterator* left, Iterator* right, 
+		               JoinSpec& leftSpec, JoinSpec& rightSpec);
+};
+
+
+//
+// Pipelined iterators for the individual join methods.
+//
+
+class TupleNestedLoopsIterator : public JoinIterator {
+public:
+	TupleNestedLoopsIterator(Iterator* outer, Iterator* inner, 
+		                     JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped);
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+
+private:
+	char *outerRec;
+};
+
+class BlockNestedLoopsIterator : public JoinIterator {
+public:
+	BlockNestedLoopsIterator(Iterator* outer, Iterator* inner, 
+		                     JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped, 
+							 int blockSize);
+	~BlockNestedLoopsIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+
+private:
+	int blockSize;
+	char *block;      // blockSize outer records, stored contiguously
+	int *blockKeys;   // join attribute of each record in block
+	int blockMin;     // smallest and largest key in block
+	int blockMax;
+	BloomFilter *blockFilter; // keys in block
+	int blockCount;   // # of records currently in block
+	int blockPos;     // next block record to compare with innerRec
+	bool outerDone;
+	bool innerOpen;
+	char *innerRec;
+
+	Status FillBlock();
+};
+
+class IndexNestedLoopsIterator : public JoinIterator {
+public:
+	IndexNestedLoopsIterator(Iterator* outer, Iterator* inner, 
+		                     JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped);
+	~IndexNestedLoopsIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+
+private:
+	BTreeFile *bTree;
+	BTreeFileScan *btScan;
+	HeapFile *innerTmp;
+	char *outerRec;
+	char *key;
+
+	// Last inner page fetched, kept pinned until a match is on another page.
+	PageID innerPid;
+	HeapPage *innerPage;
+	char *innerBuf; // copy of the inner record if the page is a PaxHeapPage
+	bool innerFormatted; // true if the inner pages are not HeapPages
+
+	BloomFilter *filter; // keys of a stored outer input, or NULL
+	bool isOpen;         // Open was called without a matching Close
+
+	Status BuildFilter();
+
+	static int numOfIndexes;
+};
+
+class SortMergeIterator : public JoinIterator {
+public:
+	SortMergeIterator(Iterator* outer, Iterator* inner, 
+		              JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped);
+	~SortMergeIterator();
+
+	Status Open();
+	Status Next(char*& recPtr);
+	Status Close();
+
+private:
+	HeapFile *sortedOuter;
+	HeapFile *sortedInner;
+	HeapFileScan *outerScan;
+	HeapFileScan *innerScan;
+	ZoneMap *outerZones; // key range of each page of the sorted relations
+	ZoneMap *innerZones;
+	int outerMax;        // largest key of each sorted relation
+	int innerMax;
+	char *outerRec;    // points into the pinned page of outerScan
+	char *innerRec;    // points into the pinned page of innerScan
+	Status outerStatus;
+	Status innerStatus;
+	RecordID innerRid;
+
+	// Start of the run of inner records matching the current outer key. 
+	bool inPartition;
+	int partitionKey;
+	RecordID partitionRid;
+
+	Status AdvanceOuter();
+	Status AdvanceInner();
 };
 
 
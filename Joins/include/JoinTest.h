@@ -9,6 +9,11 @@ private:
 
 	static void RunTest(int i);
 
+	static void RunBenchmark(int empSize, int projSize, GenOpts opts,
+	                         PageFormat format = SLOTTED_PAGES);
+
+	static Status EmptyBufferPool();
+
 	static bool TestValid(JoinSpec& l, JoinSpec &r, JoinSpec &out, int count = -1);
 
 	static bool CompareJoins(JoinMethod& j1, JoinMethod& j2, JoinSpec& leftSpec, JoinSpec& rightSpec);
@@ -18,7 +23,9 @@ private:
 								   int empSize, 
 								   int projSize, 
 								   bool foreignKey, 
-								   GenOpts opts); 
+								   GenOpts opts,
+								   PageFormat empFormat = SLOTTED_PAGES,
+								   PageFormat projFormat = SLOTTED_PAGES); 
 
 	static bool GenAndTestCount(JoinMethod* j1,
 		                        int empSize,
@@ -27,6 +34,8 @@ private:
 								GenOpts opts, 
 								int size);
 
+	static int CountIterator(Iterator* it);
+
 
 
 	// Tests TupleNestedLoops join on several statically computed relations. 
@@ -34,6 +43,9 @@ private:
 	static bool Test2();
 	static bool Test3();
 	static bool Test4();
+	static bool Test5();
+	static bool Test6();
+	static bool Test7();
 
 
 public:
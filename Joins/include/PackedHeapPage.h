@@ -0,0 +1,71 @@
+#ifndef _PACKED_HEAPPAGE_H_
+#define _PACKED_HEAPPAGE_H_
+
+#include "minirel.h"
+#include "heappage.h"
+
+#define PACKED_PAGE_TYPE 0x504B // Value of HeapPage::type for a PackedHeapPage
+
+
+// A data page holding records of integer attributes compressed column by
+// column. Each attribute is stored as a frame of reference, the smallest
+// value on the page, followed by the difference of every record's value
+// to it, bit-packed at the width of the largest difference. Attributes
+// with small domains, or ids that are close together on a page, take a
+// few bits per record instead of 32, so a page holds several times the
+// records of a FixedHeapPage.
+//
+// The data area starts with a PackedAttr per attribute, followed by the
+// packed columns. Every column is padded by one word, so a value can be
+// decoded from the two words around it without checking for the end.
+//
+// The header fields of HeapPage are reused:
+//   type       - PACKED_PAGE_TYPE
+//   freePtr    - the # of attributes of the records
+//   numOfSlots - the # of records on the page
+//
+// The widths depend on all the records of a page, so a page is written
+// at once by Pack. Records can't be inserted or deleted afterwards and are
+// returned as copies. Pages must be written with HeapFileWriter and read
+// with HeapFileScan.
+class PackedHeapPage : public HeapPage {
+public:
+	struct PackedAttr {
+		int base;     // smallest value of the attribute on the page
+		short width;  // bits per value, 0 to 32
+		short offset; // word at which the column starts
+	};
+
+	// Writes numOfRecs records of numOfAttr integers, stored one after the
+	// other in rows, to the page. mins and widths give the frame of
+	// reference and width of each attribute, see Width.
+	void Pack(PageID pageNo, const int* rows, int numOfRecs, int numOfAttr,
+		      const int* mins, const int* widths);
+
+	// Decodes attribute attr of all records into out, in slot order.
+	void Unpack(int attr, int* out);
+
+	// Copies record rid into recPtr, which must have room for it.
+	Status GetRecord(RecordID rid, char* recPtr, int& len);
+
+	int GetNumOfRecords() { return numOfSlots; }
+	int GetRecLen() { return freePtr * sizeof(int); }
+
+	// Bits needed for the values between min and max.
+	static int Width(int min, int max);
+
+	// Bytes of the data area used by numOfRecs records of numOfAttr
+	// attributes packed at the given widths.
+	static int Size(int numOfAttr, int numOfRecs, const int* widths);
+
+	// Most records on a page, whatever their widths. Never more than a
+	// HeapPage can hold, so that readers can size their buffers for HeapPage.
+	static int MaxRecords() { return HEAPPAGE_DATA_SIZE / (2 * (int)sizeof(short)); }
+
+private:
+	PackedAttr* Attrs() { return (PackedAttr *)data; }
+	unsigned int* Words() { return (unsigned int *)data; }
+	unsigned int Value(int attr, int slotNo);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _PAX_HEAPPAGE_H_
+#define _PAX_HEAPPAGE_H_
+
+#include "minirel.h"
+#include "heappage.h"
+
+#define PAX_PAGE_TYPE 0x5041 // Value of HeapPage::type for a PaxHeapPage
+
+
+// A data page holding records of integer attributes column by column
+// (PAX). The data area is split into one minipage per attribute, and
+// minipage a holds attribute a of every record on the page, in insertion
+// order. A scan that needs only one attribute, e.g. a join or sort key,
+// reads one contiguous array instead of touching every record.
+//
+// Like FixedHeapPage, the page keeps HeapPage's size and header and
+// reuses its fields:
+//   type       - PAX_PAGE_TYPE
+//   freePtr    - the # of attributes of the records
+//   freeSpace  - the # of records the page can hold
+//   numOfSlots - the # of records on the page
+//
+// Records can't be deleted, and since they aren't stored contiguously
+// they are returned as copies. Pages must be written with HeapFileWriter
+// and read with HeapFileScan.
+class PaxHeapPage : public HeapPage {
+public:
+	// Initializes the page for records of length recLen, which must be a
+	// multiple of sizeof(int).
+	void Init(PageID pageNo, int recLen);
+
+	Status InsertRecord(const char* recPtr, int recLen, RecordID& rid);
+
+	// Copies record rid into recPtr, which must have room for it.
+	Status GetRecord(RecordID rid, char* recPtr, int& len);
+
+	// Space left for new records, a multiple of the record length.
+	int AvailableSpace() { return (freeSpace - numOfSlots) * GetRecLen(); }
+	int GetNumOfRecords() { return numOfSlots; }
+	int GetRecLen() { return freePtr * sizeof(int); }
+
+	// Returns the minipage of attribute attr, indexed by slot number.
+	int* Column(int attr) { return (int *)data + attr * freeSpace; }
+
+	// # of records of length recLen that fit on a page.
+	static int Capacity(int recLen);
+};
+
+#endif
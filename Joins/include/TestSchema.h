@@ -2,6 +2,7 @@
 #define _TEST_SCHEMA_H_
 
 #include "minirel.h"
+#include "HeapFileWriter.h"
 
 
 enum GenOpts { RANDOM, ALL_MATCH, NONE_MATCH};
@@ -35,18 +36,23 @@ public:
 
 
 
+	// The relations are stored on HeapPages unless format says otherwise.
+	// Files in other formats can only be read with HeapFileScan, and must
+	// not be modified through HeapFile.
 	static Status CreateRandomEmployeeRelation(JoinSpec& spec,
 	                                           int numEmployeeRecs,
 	                                           int numProjectRecs,
 											   bool foreignKey,
-											   GenOpts opts);
+											   GenOpts opts,
+											   PageFormat format = SLOTTED_PAGES);
 	
 
 	static Status CreateRandomProjectRelation(JoinSpec& spec,
 	                                          int numEmployeeRecs,
 	                                          int numProjectRecs,
 											  bool foreignKey,
-											  GenOpts opts);
+											  GenOpts opts,
+											  PageFormat format = SLOTTED_PAGES);
 
 
 
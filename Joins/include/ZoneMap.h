@@ -0,0 +1,53 @@
+#ifndef _ZONE_MAP_H_
+#define _ZONE_MAP_H_
+
+#include "minirel.h"
+
+// Initial # of pages a ZoneMap has room for; it grows as needed.
+#define ZONE_MAP_INITIAL_SIZE 64
+
+
+// Keeps the smallest and largest value of one integer attribute for each
+// data page of a HeapFile (a zone map). A scan looking only for records
+// whose attribute lies in some range can skip the pages whose range does
+// not overlap it without pinning them. The directory pages have no room
+// for the ranges, so the map is kept in memory by whoever maintains the
+// file: HeapFileWriter fills it while appending, and HeapFileScan while
+// reading the file once in full. The map is only valid as long as the
+// file is not modified by other means.
+class ZoneMap {
+public:
+	// A map of the attribute at offset of the records.
+	ZoneMap(int offset);
+	~ZoneMap();
+
+	int GetOffset() { return offset; }
+	int GetNumOfPages() { return numOfPages; }
+
+	// Records the range of the attribute on page pid, replacing an earlier
+	// range of the page.
+	void Add(PageID pid, int min, int max);
+
+	// False if page pid is known to hold no record whose attribute lies in
+	// [low, high]; true if it may, or if the page is unknown.
+	bool MayContain(PageID pid, int low, int high);
+
+	// Sets min and max to the smallest and largest value on any page.
+	// Returns false if no page is known.
+	bool GetRange(int& min, int& max);
+
+	// Forgets all pages.
+	void Clear() { numOfPages = 0; }
+
+private:
+	int offset;
+	PageID *pids;   // ascending
+	int *mins;
+	int *maxs;
+	int numOfPages;
+	int size;       // # of pages the arrays have room for
+
+	int Find(PageID pid);
+};
+
+#endif
@@ -15,6 +15,7 @@ class DirPage
 {
 	friend class DirPageIterator;
 	friend class PageInfoIterator;
+	friend class HeapFileScan;
 
 private : 
 	int numOfEntry;
@@ -14,6 +14,8 @@ class HeapPage;
 class HeapFile 
 {
 	friend class Scan;
+	friend class HeapFileWriter;
+	friend class HeapFileScan;
 
 private :
 	
@@ -10,6 +10,8 @@ const int INVALID_SLOT =  -1;
 const int HEAPPAGE_DATA_SIZE = MAX_SPACE - 3 * sizeof(PageID) - 4 * sizeof(short);
 
 class HeapPage {
+	friend class HeapFileScan;
+	friend class HeapFileWriter;
 
 protected :
 	struct Slot 
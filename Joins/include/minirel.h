@@ -77,6 +77,11 @@ struct RecordID {
 // typedef struct RecordID RecordID;
 
 const int MINIBASE_PAGESIZE = 1024;           // in bytes
+const int MINIBASE_IO_UNIT = 8192;            // in bytes => scans and bulk 
+                                              // writers move this much data 
+                                              // at a time (READ_AHEAD_PAGES,
+                                              // WRITER_RUN_SIZE and 
+                                              // WRITER_MAX_EXTENT). 
 const int MINIBASE_BUFFER_POOL_SIZE = 1024;   // in Frames
 const int MINIBASE_DB_SIZE = 10000;           // in Pages => the DBMS Manager 
                                               // tells the DB how much disk 
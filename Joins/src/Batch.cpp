@@ -0,0 +1,496 @@
+#include <string.h>
+
+#include "Batch.h"
+#include "bufmgr.h"
+
+
+//--------------------------------------------------------------------
+// Batch::Batch
+//
+// Input   :  numOfAttr - The number of integer attributes per tuple.
+//--------------------------------------------------------------------
+Batch::Batch(int numOfAttr) {
+	this->numOfAttr = numOfAttr;
+	cols = new int[numOfAttr * BATCH_SIZE];
+	sel = new int[BATCH_SIZE];
+	numOfTuples = 0;
+	numOfSel = 0;
+}
+
+Batch::~Batch() {
+	delete [] cols;
+	delete [] sel;
+}
+
+void Batch::SelectAll() {
+	for (int i = 0; i < numOfTuples; i++) {
+		sel[i] = i;
+	}
+	numOfSel = numOfTuples;
+}
+
+
+//--------------------------------------------------------------------
+// ScanBatchIterator::ScanBatchIterator
+//
+// Input   :  child - The iterator producing the records. Its records must
+//                    consist of integer attributes.
+//--------------------------------------------------------------------
+ScanBatchIterator::ScanBatchIterator(Iterator* child) {
+	this->child = child;
+	numOfAttr = child->GetRecLen() / sizeof(int);
+	batch = new Batch(numOfAttr);
+	scan = NULL;
+	pageCount = 0;
+	pagePos = 0;
+	numOfScans = 0;
+	numOfPages = 0;
+}
+
+ScanBatchIterator::~ScanBatchIterator() {
+	delete scan;
+	delete child;
+	delete batch;
+}
+
+Status ScanBatchIterator::Open() {
+	HeapFile *file = child->GetFile();
+	if (file == NULL) return child->Open();
+
+	bool backward = false;
+	if (child->GetHint() == CYCLIC && numOfPages >= (int)MINIBASE_BM->GetNumOfBuffers()) {
+		backward = numOfScans % 2 == 0;
+		numOfScans++;
+	}
+
+	Status s;
+	scan = new HeapFileScan(file, s, backward);
+	pageCount = 0;
+	pagePos = 0;
+	if (s != OK) {
+		std::cerr << "Failed to open scan on HeapFile." << std::endl;
+		delete scan;
+		scan = NULL;
+		return FAIL;
+	}
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// ScanBatchIterator::NextFromPages
+//
+// Purpose :  Fills the batch with whole pages of the child's file,
+//            scattering the records of a page into the columns one
+//            attribute at a time.
+// Output  :  n - The # of tuples in the batch.
+//--------------------------------------------------------------------
+Status ScanBatchIterator::NextFromPages(int& n) {
+	n = 0;
+	while (n < BATCH_SIZE) {
+		if (pagePos == pageCount) {
+			RecordID *rids;
+			Status s = scan->NextPage(pageRecs, rids, pageCount);
+			pagePos = 0;
+			if (s == DONE) {
+				pageCount = 0;
+				break;
+			}
+			if (s != OK) return FAIL;
+		}
+
+		int num = pageCount - pagePos;
+		if (num > BATCH_SIZE - n) num = BATCH_SIZE - n;
+
+		char **recs = pageRecs + pagePos;
+		for (int a = 0; a < numOfAttr; a++) {
+			int *col = batch->Column(a) + n;
+			for (int k = 0; k < num; k++) {
+				col[k] = ((int*)recs[k])[a];
+			}
+		}
+		n += num;
+		pagePos += num;
+	}
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// ScanBatchIterator::NextFromChild
+//
+// Purpose :  Fills the batch with records pulled from the child.
+// Output  :  n - The # of tuples in the batch.
+//--------------------------------------------------------------------
+Status ScanBatchIterator::NextFromChild(int& n) {
+	n = 0;
+	while (n < BATCH_SIZE) {
+		char *rec;
+		Status s = child->Next(rec);
+		if (s == DONE) break;
+		if (s != OK) return FAIL;
+
+		// Scatter the record into the columns
+		int *intRec = (int*)rec;
+		for (int a = 0; a < numOfAttr; a++) {
+			batch->Column(a)[n] = intRec[a];
+		}
+		n++;
+	}
+	return OK;
+}
+
+Status ScanBatchIterator::Next(Batch*& batch) {
+	int n;
+	Status s = (scan != NULL) ? NextFromPages(n) : NextFromChild(n);
+	if (s != OK) return FAIL;
+
+	if (n == 0) return DONE;
+	this->batch->numOfTuples = n;
+	this->batch->SelectAll();
+	batch = this->batch;
+	return OK;
+}
+
+Status ScanBatchIterator::Close() {
+	if (scan == NULL) return child->Close();
+
+	if (scan->GetNumOfPagesRead() > numOfPages) {
+		numOfPages = scan->GetNumOfPagesRead();
+	}
+	delete scan;
+	scan = NULL;
+	return OK;
+}
+
+
+//--------------------------------------------------------------------
+// FilterBatchIterator::FilterBatchIterator
+//
+// Input   :  child  - The operator producing the batches to filter.
+//            attr   - The attribute to test.
+//            op     - The comparison to apply (aopEQ ... aopGE).
+//            value  - The constant to compare the attribute with.
+//--------------------------------------------------------------------
+FilterBatchIterator::FilterBatchIterator(BatchIterator* child, int attr,
+	                                     AttrOperator op, int value) {
+	this->child = child;
+	this->attr = attr;
+	this->op = op;
+	this->value = value;
+	numOfAttr = child->GetNumOfAttr();
+}
+
+FilterBatchIterator::~FilterBatchIterator() {
+	delete child;
+}
+
+Status FilterBatchIterator::Open() {
+	return child->Open();
+}
+
+//--------------------------------------------------------------------
+// FilterBatchIterator::Next
+//
+// Purpose :  Shrinks the selection vector of the child's batches in
+//            place. The comparison is chosen once per batch and the
+//            inner loops are branch free: every position is written and
+//            the output count only advances when the predicate holds.
+//--------------------------------------------------------------------
+Status FilterBatchIterator::Next(Batch*& batch) {
+	while (true) {
+		Status s = child->Next(batch);
+		if (s != OK) return s;
+
+		int *col = batch->Column(attr);
+		int *sel = batch->sel;
+		int num = batch->numOfSel;
+		int n = 0;
+		int i;
+		switch (op) {
+		case aopEQ: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] == value); } break;
+		case aopLT: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] <  value); } break;
+		case aopGT: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] >  value); } break;
+		case aopNE: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] != value); } break;
+		case aopLE: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] <= value); } break;
+		case aopGE: for (i = 0; i < num; i++) { sel[n] = sel[i]; n += (col[sel[i]] >= value); } break;
+		default:
+			std::cerr << "Unsupported operator in FilterBatchIterator." << std::endl;
+			return FAIL;
+		}
+		batch->numOfSel = n;
+
+		if (n > 0) return OK;
+	}
+}
+
+Status FilterBatchIterator::Close() {
+	return child->Close();
+}
+
+
+//--------------------------------------------------------------------
+// BatchJoinIterator::BatchJoinIterator
+//
+// Input   :  outer     - The outer input, scanned once.
+//            inner     - The inner input, rescanned once per block.
+//            outerAttr - The join attribute of the outer input.
+//            innerAttr - The join attribute of the inner input.
+//            swapped   - True iff outer is the right relation of the join.
+//            blockSize - The number of outer tuples per block.
+//--------------------------------------------------------------------
+BatchJoinIterator::BatchJoinIterator(BatchIterator* outer, BatchIterator* inner,
+	                                 int outerAttr, int innerAttr,
+									 bool swapped, int blockSize) {
+	this->outer = outer;
+	this->inner = inner;
+	this->outerAttr = outerAttr;
+	this->innerAttr = innerAttr;
+	this->swapped = swapped;
+	this->blockSize = blockSize;
+	numOfAttr = outer->GetNumOfAttr() + inner->GetNumOfAttr();
+
+	block = new int[outer->GetNumOfAttr() * blockSize];
+	blockCount = 0;
+	outerDone = true;
+	outerBatch = NULL;
+	outerBatchPos = 0;
+
+	innerOpen = false;
+	innerBatch = NULL;
+	innerKeys = new int[BATCH_SIZE];
+	numOfInner = 0;
+	probePos = 0;
+
+	out = new Batch(numOfAttr);
+	outerIdx = new int[BATCH_SIZE];
+	innerIdx = new int[BATCH_SIZE];
+}
+
+BatchJoinIterator::~BatchJoinIterator() {
+	delete outer;
+	delete inner;
+	delete [] block;
+	delete [] innerKeys;
+	delete out;
+	delete [] outerIdx;
+	delete [] innerIdx;
+}
+
+//--------------------------------------------------------------------
+// BatchJoinIterator::FillBlock
+//
+// Purpose :  Copies the next blockSize selected outer tuples into block.
+//            An outer batch that does not fit is finished by the next
+//            call.
+//--------------------------------------------------------------------
+Status BatchJoinIterator::FillBlock() {
+	int outerAttrs = outer->GetNumOfAttr();
+	blockCount = 0;
+	while (blockCount < blockSize) {
+		if (outerBatch == NULL || outerBatchPos == outerBatch->numOfSel) {
+			Status s = outer->Next(outerBatch);
+			if (s == DONE) {
+				outerBatch = NULL;
+				outerDone = true;
+				break;
+			}
+			if (s != OK) return FAIL;
+			outerBatchPos = 0;
+		}
+
+		int n = outerBatch->numOfSel - outerBatchPos;
+		if (n > blockSize - blockCount) n = blockSize - blockCount;
+
+		int *sel = outerBatch->sel + outerBatchPos;
+		for (int a = 0; a < outerAttrs; a++) {
+			int *src = outerBatch->Column(a);
+			int *dst = block + a * blockSize + blockCount;
+			for (int i = 0; i < n; i++) {
+				dst[i] = src[sel[i]];
+			}
+		}
+		blockCount += n;
+		outerBatchPos += n;
+	}
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BatchJoinIterator::Probe
+//
+// Purpose :  Compares block tuples, starting at probePos, with every
+//            selected tuple of the current inner batch and records the
+//            matching pairs in outerIdx/innerIdx. Stops before a block
+//            tuple whose matches might not fit in the output batch.
+//--------------------------------------------------------------------
+void BatchJoinIterator::Probe() {
+	int *keys = block + outerAttr * blockSize;
+	int *innerSel = innerBatch->sel;
+	int count = 0;
+
+	while (probePos < blockCount && count + numOfInner <= BATCH_SIZE) {
+		int key = keys[probePos];
+		for (int j = 0; j < numOfInner; j++) {
+			outerIdx[count] = probePos;
+			innerIdx[count] = innerSel[j];
+			count += (innerKeys[j] == key);
+		}
+		probePos++;
+	}
+	out->numOfTuples = count;
+}
+
+//--------------------------------------------------------------------
+// BatchJoinIterator::Gather
+//
+// Purpose :  Builds the output columns of the pairs found by Probe, in
+//            <left, right> order.
+//--------------------------------------------------------------------
+void BatchJoinIterator::Gather() {
+	int outerAttrs = outer->GetNumOfAttr();
+	int innerAttrs = inner->GetNumOfAttr();
+	int outerFirst = swapped ? innerAttrs : 0;
+	int innerFirst = swapped ? 0 : outerAttrs;
+	int count = out->numOfTuples;
+
+	for (int a = 0; a < outerAttrs; a++) {
+		int *src = block + a * blockSize;
+		int *dst = out->Column(outerFirst + a);
+		for (int k = 0; k < count; k++) {
+			dst[k] = src[outerIdx[k]];
+		}
+	}
+	for (int a = 0; a < innerAttrs; a++) {
+		int *src = innerBatch->Column(a);
+		int *dst = out->Column(innerFirst + a);
+		for (int k = 0; k < count; k++) {
+			dst[k] = src[innerIdx[k]];
+		}
+	}
+	out->SelectAll();
+}
+
+Status BatchJoinIterator::Open() {
+	if (outer->Open() != OK) return FAIL;
+	outerDone = false;
+	outerBatch = NULL;
+	innerBatch = NULL;
+
+	if (FillBlock() != OK) return FAIL;
+	if (blockCount == 0) return OK;
+
+	if (inner->Open() != OK) {
+		std::cerr << "Failed to open inner input of batch join." << std::endl;
+		return FAIL;
+	}
+	innerOpen = true;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BatchJoinIterator::Next
+//
+// Purpose :  Returns the next batch of matching <outer, inner> pairs.
+//--------------------------------------------------------------------
+Status BatchJoinIterator::Next(Batch*& batch) {
+	while (true) {
+		if (innerBatch != NULL && probePos < blockCount) {
+			Probe();
+			if (out->numOfTuples > 0) {
+				Gather();
+				batch = out;
+				return OK;
+			}
+		}
+
+		if (blockCount == 0) return DONE;
+
+		Status s = inner->Next(innerBatch);
+		if (s == OK) {
+			// Pack the join attribute of the selected inner tuples
+			int *col = innerBatch->Column(innerAttr);
+			numOfInner = innerBatch->numOfSel;
+			for (int j = 0; j < numOfInner; j++) {
+				innerKeys[j] = col[innerBatch->sel[j]];
+			}
+			probePos = 0;
+			continue;
+		}
+		innerBatch = NULL;
+		if (s != DONE) return FAIL;
+
+		// End of the inner input, move on to the next block
+		inner->Close();
+		innerOpen = false;
+		if (outerDone) {
+			blockCount = 0;
+			return DONE;
+		}
+		if (FillBlock() != OK) return FAIL;
+		if (blockCount == 0) return DONE;
+
+		if (inner->Open() != OK) {
+			std::cerr << "Failed to open inner input of batch join." << std::endl;
+			return FAIL;
+		}
+		innerOpen = true;
+	}
+}
+
+Status BatchJoinIterator::Close() {
+	if (innerOpen) {
+		inner->Close();
+		innerOpen = false;
+	}
+	innerBatch = NULL;
+	outerBatch = NULL;
+	blockCount = 0;
+	return outer->Close();
+}
+
+
+//--------------------------------------------------------------------
+// BatchToRowIterator::BatchToRowIterator
+//
+// Input   :  child - The batch operator to read from.
+//--------------------------------------------------------------------
+BatchToRowIterator::BatchToRowIterator(BatchIterator* child) {
+	this->child = child;
+	recLen = child->GetNumOfAttr() * sizeof(int);
+	batch = NULL;
+	pos = 0;
+	rec = new char[recLen];
+}
+
+BatchToRowIterator::~BatchToRowIterator() {
+	delete child;
+	delete [] rec;
+}
+
+Status BatchToRowIterator::Open() {
+	batch = NULL;
+	return child->Open();
+}
+
+Status BatchToRowIterator::Next(char*& recPtr) {
+	if (batch == NULL || pos == batch->numOfSel) {
+		Status s = child->Next(batch);
+		if (s != OK) {
+			batch = NULL;
+			return s;
+		}
+		pos = 0;
+	}
+
+	int i = batch->sel[pos++];
+	int *intRec = (int*)rec;
+	for (int a = 0; a < batch->numOfAttr; a++) {
+		intRec[a] = batch->Column(a)[i];
+	}
+	recPtr = rec;
+	return OK;
+}
+
+Status BatchToRowIterator::Close() {
+	batch = NULL;
+	return child->Close();
+}
@@ -0,0 +1,59 @@
+#include "join.h"
+#include "Batch.h"
+
+//---------------------------------------------------------------
+// BatchNestedLoops::Execute
+//
+// Input:   left  - The left relation to join.
+//          right - The right relation to join.
+// Output:  out   - The relation to hold the ouptut.
+// Return:  OK if join completed succesfully. FAIL otherwise.
+//
+// Purpose: Performs a block nested loops join on the specified relations,
+// exchanging column-wise batches of BATCH_SIZE tuples between operators
+// instead of single records. The block size is stored in blockSize.
+//---------------------------------------------------------------
+Status BatchNestedLoops::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	BufStatsScope scope("BatchNestedLoops");
+	JoinMethod::Execute(left, right, out);
+
+	Iterator *it = CreateIterator(left, right);
+	Status s = Materialize(it, out);
+	delete it;
+
+	return s;
+}
+
+//---------------------------------------------------------------
+// BatchNestedLoops::Pipeline
+//
+// Input:   left      - The left input to join.
+//          right     - The right input to join.
+//          leftSpec  - Describes the records produced by left.
+//          rightSpec - Describes the records produced by right.
+// Return:  A pipelined iterator over the join. When both inputs are
+//          stored relations, the smaller one is used as the outer
+//          relation; otherwise left is the outer relation.
+//---------------------------------------------------------------
+Iterator* BatchNestedLoops::Pipeline(Iterator* left, Iterator* right,
+	                                 JoinSpec& leftSpec, JoinSpec& rightSpec) {
+	BatchIterator *leftBatches = new ScanBatchIterator(left);
+	BatchIterator *rightBatches = new ScanBatchIterator(right);
+	int leftAttr = leftSpec.offset / sizeof(int);
+	int rightAttr = rightSpec.offset / sizeof(int);
+
+	// Make sure outer relation is smaller, if not need to swap inputs
+	BatchIterator *join;
+	if (leftSpec.file != NULL && rightSpec.file != NULL &&
+		leftSpec.GetNumOfRecords() > rightSpec.GetNumOfRecords()) {
+		left->SetHint(CYCLIC);
+		join = new BatchJoinIterator(rightBatches, leftBatches, rightAttr, leftAttr,
+			                         true, blockSize);
+	}
+	else {
+		right->SetHint(CYCLIC);
+		join = new BatchJoinIterator(leftBatches, rightBatches, leftAttr, rightAttr,
+			                         false, blockSize);
+	}
+	return new BatchToRowIterator(join);
+}
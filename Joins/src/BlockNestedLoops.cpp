@@ -1,242 +1,193 @@
+#include <string.h>
+
 #include "join.h"
 #include "scan.h"
 
-#include <vector>
-
 //---------------------------------------------------------------
 // BlockNestedLoop::Execute
 //
-// Input:   left  - The left relation to join. 
-//          right - The right relation to join. 
-// Output:  out   - The relation to hold the ouptut. 
-// Return:  OK if join completed succesfully. FAIL otherwise. 
-//          
-// Purpose: Performs a block nested loops join on the specified relations. 
-// You can find a specification of this algorithm on page 455. You should 
-// choose the smaller of the two relations to be the outer relation, but you 
-// should make sure to concatenate the tuples in order <left, right> when 
-// producing output. The block size can be specified in the constructor, 
-// and is stored in the variable blockSize. 
+// Input:   left  - The left relation to join.
+//          right - The right relation to join.
+// Output:  out   - The relation to hold the ouptut.
+// Return:  OK if join completed succesfully. FAIL otherwise.
+//
+// Purpose: Performs a block nested loops join on the specified relations.
+// You can find a specification of this algorithm on page 455. You should
+// choose the smaller of the two relations to be the outer relation, but you
+// should make sure to concatenate the tuples in order <left, right> when
+// producing output. The block size can be specified in the constructor,
+// and is stored in the variable blockSize.
 //---------------------------------------------------------------
 Status BlockNestedLoops::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	BufStatsScope scope("BlockNestedLoops");
 	JoinMethod::Execute(left, right, out);
 
-	// Make sure left relation is smaller, if not need to swap JoinSpecs
-	bool swapped = false;
-	if (left.file->GetNumOfRecords() > right.file->GetNumOfRecords()) {
-		JoinSpec tmp = left;
-		left = right;
-		right = tmp;
+	Iterator *it = CreateIterator(left, right);
+	Status s = Materialize(it, out);
+	delete it;
+
+	return s;
+}
 
-		swapped = true;
+//---------------------------------------------------------------
+// BlockNestedLoops::Pipeline
+//
+// Input:   left      - The left input to join.
+//          right     - The right input to join.
+//          leftSpec  - Describes the records produced by left.
+//          rightSpec - Describes the records produced by right.
+// Return:  A pipelined iterator over the join. When both inputs are
+//          stored relations, the smaller one is used as the outer
+//          relation; otherwise left is the outer relation.
+//---------------------------------------------------------------
+Iterator* BlockNestedLoops::Pipeline(Iterator* left, Iterator* right,
+	                                 JoinSpec& leftSpec, JoinSpec& rightSpec) {
+	// Make sure outer relation is smaller, if not need to swap inputs
+	if (leftSpec.file != NULL && rightSpec.file != NULL &&
+		leftSpec.GetNumOfRecords() > rightSpec.GetNumOfRecords()) {
+		return new BlockNestedLoopsIterator(right, left, rightSpec, leftSpec, true, blockSize);
 	}
+	return new BlockNestedLoopsIterator(left, right, leftSpec, rightSpec, false, blockSize);
+}
 
-	// Create temporary heapfile
-	Status s;
-	HeapFile *tmpHeap = new HeapFile(NULL, s);
-	if (s != OK) {
-		std::cerr << "Failed to create output heapfile." << std::endl;
-		return FAIL;
+
+BlockNestedLoopsIterator::BlockNestedLoopsIterator(Iterator* outer, Iterator* inner,
+	                                               JoinSpec& outerSpec, JoinSpec& innerSpec,
+												   bool swapped, int blockSize)
+	: JoinIterator(outer, inner, outerSpec, innerSpec, swapped) {
+	this->blockSize = blockSize;
+	block = new char[blockSize * outerSpec.recLen];
+	blockKeys = new int[blockSize];
+	blockFilter = new BloomFilter(blockSize);
+	blockCount = 0;
+	blockMin = 0;
+	blockMax = 0;
+	blockPos = 0;
+	outerDone = true;
+	innerOpen = false;
+	innerRec = NULL;
+	inner->SetHint(CYCLIC);
+}
+
+BlockNestedLoopsIterator::~BlockNestedLoopsIterator() {
+	delete [] block;
+	delete [] blockKeys;
+	delete blockFilter;
+}
+
+//---------------------------------------------------------------
+// BlockNestedLoopsIterator::FillBlock
+//
+// Purpose: Reads the next blockSize records of the outer input into
+//          block, along with their join attributes. The keys go into
+//          the block's Bloom filter, and their range is passed on to
+//          the inner input.
+//---------------------------------------------------------------
+Status BlockNestedLoopsIterator::FillBlock() {
+	blockCount = 0;
+	blockFilter->Clear();
+	while (blockCount < blockSize) {
+		char *outerRec;
+		Status outerStatus = outer->Next(outerRec);
+		if (outerStatus == DONE) {
+			outerDone = true;
+			break;
+		}
+		if (outerStatus != OK) return FAIL;
+
+		memcpy(block + blockCount * outerSpec.recLen, outerRec, outerSpec.recLen);
+		int key = *(int*)(outerRec + outerSpec.offset);
+		blockKeys[blockCount] = key;
+		blockFilter->Add(key);
+		if (blockCount == 0 || key < blockMin) blockMin = key;
+		if (blockCount == 0 || key > blockMax) blockMax = key;
+		blockCount++;
 	}
 
-	// Open scan on left relation
-	Status leftStatus;
-	Scan *leftScan = left.file->OpenScan(leftStatus);
-	if (leftStatus != OK) {
-		std::cerr << "Failed to open scan on left relation." << std::endl;
-		return FAIL;
+	if (blockCount > 0) {
+		inner->SetKeyRange(innerSpec.offset, blockMin, blockMax);
 	}
+	return OK;
+}
 
-	// Create array to store block
-	std::vector<char *> *block = new std::vector<char *>(this->blockSize);
-	bool lastBlock = false;
-	int lastRecPos = block->size(); // determines when to stop iterating through block if it is ever unfilled
+Status BlockNestedLoopsIterator::Open() {
+	if (outer->Open() != OK) return FAIL;
+	outerDone = false;
+	innerRec = NULL;
+	blockPos = 0;
 
-	// Begin loop
-	while (true) {
-		if (lastBlock) break;
-
-		// Read block into array
-		for (int i = 0; i < this->blockSize; i++) {
-			(*block)[i] = new char[left.recLen];		
-			RecordID leftRid;
-			leftStatus = leftScan->GetNext(leftRid, (*block)[i], left.recLen);
-			if (leftStatus == DONE) {
-				lastBlock = true;
-				lastRecPos = i;
-				break;
-			}
-			if (leftStatus != OK) return FAIL;
-		}
+	if (FillBlock() != OK) return FAIL;
+	if (blockCount == 0) return OK;
 
-		// Open scan on right relation
-		Status rightStatus;
-		Scan *rightScan = right.file->OpenScan(rightStatus);
-		if (rightStatus != OK) {
-			std::cerr << "Failed to open scan on right relation." << std::endl;
-			return FAIL;
-		}
+	if (inner->Open() != OK) {
+		std::cerr << "Failed to open scan on inner relation." << std::endl;
+		return FAIL;
+	}
+	innerOpen = true;
+	return OK;
+}
 
-		// Loop over right relation
-		char *rightRec = new char[right.recLen];
-		while (true) {
-			RecordID rightRid;
-			rightStatus = rightScan->GetNext(rightRid, rightRec, right.recLen);
-			if (rightStatus == DONE) break;
-			if (rightStatus != OK) return FAIL;
-
-			// Join attribute on the right relation
-			int *rightJoinValPtr = (int*)(rightRec + right.offset);
-			
-			// Compare current tuple from right relation to each tuple in array
-			for (int i = 0; i < block->size(); i++) {
-				if (i == lastRecPos) break;
-				
-				// Join attribute on the left relation
-				int *leftJoinValPtr = (int*)((*block)[i] + left.offset);
-				if (*leftJoinValPtr == *rightJoinValPtr) {
-				// Create the record and insert into tmpHeap
-					char *joinedRec = new char[out.recLen];
-
-					// Need to check if JoinSpecs have been swapped
-					if (swapped) 
-						MakeNewRecord(joinedRec, rightRec, (*block)[i], right, left);
-					else
-						MakeNewRecord(joinedRec, (*block)[i], rightRec, left, right);
-
-					RecordID insertedRid;
-					Status tmpStatus = tmpHeap->InsertRecord(joinedRec, out.recLen, insertedRid);
-					
-					if (tmpStatus != OK) {
-						std::cerr << "Failed to insert tuple into output file." << std::endl;
-						return FAIL;
-					}
-
-					delete [] joinedRec;
+//---------------------------------------------------------------
+// BlockNestedLoopsIterator::Next
+//
+// Purpose: Returns the next matching <outer, inner> pair. Each inner
+//          tuple is compared with every tuple of the current block
+//          before moving on; the inner input is rescanned once per block.
+//          Inner tuples whose key is not in the block's Bloom filter
+//          skip the comparisons.
+//---------------------------------------------------------------
+Status BlockNestedLoopsIterator::Next(char*& recPtr) {
+	while (true) {
+		// Compare current inner tuple to the rest of the block
+		if (innerRec != NULL) {
+			int innerKey = *(int*)(innerRec + innerSpec.offset);
+			while (blockPos < blockCount) {
+				int i = blockPos++;
+				if (blockKeys[i] == innerKey) {
+					recPtr = Join(block + i * outerSpec.recLen, innerRec);
+					return OK;
 				}
 			}
 		}
 
-		delete [] rightRec;
-		delete rightScan;
-	}
+		if (blockCount == 0) return DONE;
 
-	out.file = tmpHeap;
-	delete leftScan;
-	delete block;
+		Status innerStatus = inner->Next(innerRec);
+		if (innerStatus == OK) {
+			int innerKey = *(int*)(innerRec + innerSpec.offset);
+			blockPos = blockFilter->MayContain(innerKey) ? 0 : blockCount;
+			continue;
+		}
+		innerRec = NULL;
+		if (innerStatus != DONE) return FAIL;
+
+		// End of the inner input, move on to the next block
+		inner->Close();
+		innerOpen = false;
+		if (outerDone) {
+			blockCount = 0;
+			return DONE;
+		}
+		if (FillBlock() != OK) return FAIL;
+		if (blockCount == 0) return DONE;
 
-	return OK;
+		if (inner->Open() != OK) {
+			std::cerr << "Failed to open scan on inner relation." << std::endl;
+			return FAIL;
+		}
+		innerOpen = true;
+	}
 }
 
-
-//Status BlockNestedLoops::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
-//	JoinMethod::Execute(left, right, out);
-//	
-//
-//	struct Tuple {
-//		char *leftRec;
-//		int *leftJoinValPtr;
-//	};
-//
-//	// Create temporary heapfile
-//	Status s;
-//	HeapFile *tmpHeap = new HeapFile(NULL, s);
-//	if (s != OK) {
-//		std::cerr << "Failed to create output heapfile." << std::endl;
-//		return FAIL;
-//	}
-//
-//	// Open scan on left relation
-//	Status leftStatus;
-//	Scan *leftScan = left.file->OpenScan(leftStatus);
-//	if (leftStatus != OK) {
-//		std::cerr << "Failed to open scan on left relation." << std::endl;
-//		return FAIL;
-//	}
-//
-//
-//	std::vector<Tuple *> block(this->blockSize);
-//	bool lastBlock = false;
-//	int cap = block.size();
-//	//could create int for max position to go into block;
-//
-//	// Loop over the left relation
-////	char *leftRec =nullptr;	
-//	while (true) {
-//
-//		if (lastBlock) break;
-//
-//		// Create block from left relation
-//		for (int i = 0; i < this->blockSize; i++) {
-//			
-//			Tuple *t = new Tuple();
-//			t->leftRec = new char[left.recLen];
-//			
-//			RecordID leftRid;
-//			leftStatus = leftScan->GetNext(leftRid, t->leftRec, left.recLen);
-//			if (leftStatus == DONE) {
-//				// might need to make new array of size i+1 and copy current contents;
-//				// or make sure to clean array at end of right scan.
-//				lastBlock = true;
-//				cap = i;
-//				break;
-//			}
-//			if (leftStatus != OK) return FAIL;
-//
-//			// Store join attribute from left relation
-//
-//			t->leftJoinValPtr = (int*)(t->leftRec + left.offset);;
-//
-//			block[i] = t;
-//		}
-//
-//		// Open scan on right relation
-//		Status rightStatus;
-//		Scan *rightScan = right.file->OpenScan(rightStatus);
-//		if (rightStatus != OK) {
-//			std::cerr << "Failed to open scan on right relation." << std::endl;
-//			return FAIL;
-//		}
-//
-//		// Loop over right relation
-//		char *rightRec = new char[right.recLen];
-//		while (true) {
-//			RecordID rightRid;
-//			rightStatus = rightScan->GetNext(rightRid, rightRec, right.recLen);
-//			if (rightStatus == DONE) break;
-//			if (rightStatus != OK) return FAIL;
-//
-//			// Compare join attribute
-//			int *rightJoinValPtr = (int*)(rightRec + right.offset);
-//			
-//			for (int i = 0; i < block.size(); i++) {
-//				if (i == cap) break;
-//
-//				if (*(block[i]->leftJoinValPtr) == *rightJoinValPtr) {
-//				// Create the record and insert into tmpHeap
-//					char *joinedRec = new char[out.recLen];
-//					// need to store leftRec somewhere in array
-//					MakeNewRecord(joinedRec, block[i]->leftRec, rightRec, left, right);
-//					RecordID insertedRid;
-//					Status tmpStatus = tmpHeap->InsertRecord(joinedRec, out.recLen, insertedRid);
-//					
-//					if (tmpStatus != OK) {
-//						std::cerr << "Failed to insert tuple into output file." << std::endl;
-//						return FAIL;
-//					}
-//
-//					delete [] joinedRec;
-//				}
-//			}
-//		}
-//
-//		delete [] rightRec;
-//		delete rightScan;
-//	}
-//
-//	out.file = tmpHeap;
-//	delete leftScan;
-//
-//
-//	return OK;
-//}
+Status BlockNestedLoopsIterator::Close() {
+	if (innerOpen) {
+		inner->Close();
+		innerOpen = false;
+	}
+	// The key range only held for the blocks of this run; a reopened join
+	// or another reader of the inner relation needs all its records. 
+	inner->ClearKeyRange();
+	innerRec = NULL;
+	blockCount = 0;
+	return outer->Close();
+}
@@ -0,0 +1,112 @@
+#include <string.h>
+
+#include "BloomFilter.h"
+
+long BloomFilter::numOfProbes = 0;
+long BloomFilter::numOfPasses = 0;
+
+
+//--------------------------------------------------------------------
+// BloomFilter::BloomFilter
+//
+// Input   :  numOfKeys - The # of keys the filter is sized for. The #
+//                        of words is rounded up to a power of 2.
+//--------------------------------------------------------------------
+BloomFilter::BloomFilter(int numOfKeys) {
+	unsigned int numOfWords = 1;
+	while (numOfWords * 64 < (unsigned int)numOfKeys * BLOOM_BITS_PER_KEY) {
+		numOfWords *= 2;
+	}
+	mask = numOfWords - 1;
+	words = new unsigned long long[numOfWords];
+	Clear();
+}
+
+BloomFilter::~BloomFilter() {
+	delete [] words;
+}
+
+void BloomFilter::Clear() {
+	memset(words, 0, (mask + 1) * sizeof(unsigned long long));
+	numOfKeys = 0;
+	minKey = 0;
+	maxKey = 0;
+}
+
+bool BloomFilter::GetRange(int& min, int& max) {
+	if (numOfKeys == 0) return false;
+	min = minKey;
+	max = maxKey;
+	return true;
+}
+
+//--------------------------------------------------------------------
+// BloomFilter::Hash
+//
+// Purpose :  Mixes the bits of key (the finalizer of SplitMix64), so
+//            that keys close to each other land in unrelated words.
+//--------------------------------------------------------------------
+unsigned long long BloomFilter::Hash(int key) {
+	unsigned long long h = (unsigned long long)(unsigned int)key + 0x9E3779B97F4A7C15ULL;
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+	return h ^ (h >> 31);
+}
+
+//--------------------------------------------------------------------
+// BloomFilter::KeyBits
+//
+// Return  :  The bits of the key's word to set or test, taken from the
+//            low 6-bit groups of hash. The word is chosen by the high
+//            32 bits.
+//--------------------------------------------------------------------
+unsigned long long BloomFilter::KeyBits(unsigned long long hash) {
+	unsigned long long bits = 0;
+	for (int i = 0; i < BLOOM_BITS_PER_WORD; i++) {
+		bits |= 1ULL << ((hash >> (6 * i)) & 63);
+	}
+	return bits;
+}
+
+void BloomFilter::Add(int key) {
+	if (numOfKeys == 0 || key < minKey) minKey = key;
+	if (numOfKeys == 0 || key > maxKey) maxKey = key;
+	numOfKeys++;
+
+	unsigned long long h = Hash(key);
+	words[(unsigned int)(h >> 32) & mask] |= KeyBits(h);
+}
+
+bool BloomFilter::MayContain(int key) {
+	numOfProbes++;
+	if (numOfKeys == 0 || key < minKey || key > maxKey) return false;
+
+	unsigned long long h = Hash(key);
+	unsigned long long bits = KeyBits(h);
+	bool pass = (words[(unsigned int)(h >> 32) & mask] & bits) == bits;
+
+	if (pass) numOfPasses++;
+	return pass;
+}
+
+void BloomFilter::GetStat(long& probes, long& passes) {
+	probes = numOfProbes;
+	passes = numOfPasses;
+}
+
+void BloomFilter::ResetStat() {
+	numOfProbes = 0;
+	numOfPasses = 0;
+}
+
+//--------------------------------------------------------------------
+// BloomFilter::PrintStat
+//
+// Purpose :  Writes the # of probes and the fraction that passed, if
+//            any filter was probed since the last ResetStat.
+//--------------------------------------------------------------------
+void BloomFilter::PrintStat(std::ostream& out) {
+	if (numOfProbes == 0) return;
+	out << "BloomFilter: " << numOfPasses << " of " << numOfProbes << " probes passed ("
+		<< 100.0 * numOfPasses / numOfProbes << "%)" << std::endl;
+}
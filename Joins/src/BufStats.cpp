@@ -0,0 +1,123 @@
+#include <string.h>
+
+#include "BufStats.h"
+#include "bufmgr.h"
+
+
+static const char *names[MAX_STAT_ENTRIES];
+static long pins[MAX_STAT_ENTRIES];
+static long misses[MAX_STAT_ENTRIES];
+static long reads[MAX_STAT_ENTRIES];
+static int numOfEntries = 0;
+
+static int stack[MAX_STAT_DEPTH]; // entries of the open scopes
+static int depth = 0;             // # of open scopes, may exceed MAX_STAT_DEPTH
+static long lastPins = 0;         // BufMgr counters when last charged
+static long lastMisses = 0;
+
+
+//--------------------------------------------------------------------
+// BufStats::Find
+//
+// Input   :  name - The name of a scope. Must stay valid until Reset.
+// Return  :  The entry counting name, added if needed, or -1 if there
+//            is no room for another entry.
+//--------------------------------------------------------------------
+int BufStats::Find(const char* name) {
+	for (int i = 0; i < numOfEntries; i++) {
+		if (!strcmp(names[i], name)) return i;
+	}
+	if (numOfEntries == MAX_STAT_ENTRIES) return -1;
+
+	names[numOfEntries] = name;
+	pins[numOfEntries] = 0;
+	misses[numOfEntries] = 0;
+	reads[numOfEntries] = 0;
+	return numOfEntries++;
+}
+
+//--------------------------------------------------------------------
+// BufStats::Charge
+//
+// Purpose :  Charges the pins and misses since the last call to the
+//            innermost open scope.
+//--------------------------------------------------------------------
+void BufStats::Charge() {
+	long p, m;
+	MINIBASE_BM->GetStat(p, m);
+
+	// The counters were reset in between, count from zero
+	if (p < lastPins || m < lastMisses) {
+		lastPins = 0;
+		lastMisses = 0;
+	}
+
+	if (depth > 0 && depth <= MAX_STAT_DEPTH && stack[depth - 1] >= 0) {
+		pins[stack[depth - 1]] += p - lastPins;
+		misses[stack[depth - 1]] += m - lastMisses;
+	}
+	lastPins = p;
+	lastMisses = m;
+}
+
+void BufStats::Enter(const char* name) {
+	Charge();
+	if (depth < MAX_STAT_DEPTH) {
+		stack[depth] = Find(name);
+	}
+	depth++;
+}
+
+void BufStats::Leave() {
+	if (depth == 0) return;
+	Charge();
+	depth--;
+}
+
+void BufStats::AddReads(int numOfPages) {
+	if (depth > 0 && depth <= MAX_STAT_DEPTH && stack[depth - 1] >= 0) {
+		reads[stack[depth - 1]] += numOfPages;
+	}
+}
+
+bool BufStats::Get(const char* name, long& pins, long& misses, long& reads) {
+	for (int i = 0; i < numOfEntries; i++) {
+		if (!strcmp(names[i], name)) {
+			pins = ::pins[i];
+			misses = ::misses[i];
+			reads = ::reads[i];
+			return true;
+		}
+	}
+	pins = misses = reads = 0;
+	return false;
+}
+
+//--------------------------------------------------------------------
+// BufStats::Print
+//
+// Purpose :  Writes one line per entry with its pins, misses, miss rate
+//            and reads outside the buffer pool.
+//--------------------------------------------------------------------
+void BufStats::Print(std::ostream& out) {
+	Charge();
+	for (int i = 0; i < numOfEntries; i++) {
+		out << names[i] << ": " << pins[i] << " pins, " << misses[i] << " misses ("
+			<< (pins[i] > 0 ? 100.0 * misses[i] / pins[i] : 0.0) << "%), "
+			<< reads[i] << " ring reads" << std::endl;
+	}
+}
+
+//--------------------------------------------------------------------
+// BufStats::Reset
+//
+// Purpose :  Clears all entries. Scopes that are open stop counting
+//            until they are left.
+//--------------------------------------------------------------------
+void BufStats::Reset() {
+	Charge();
+	for (int i = 0; i < depth && i < MAX_STAT_DEPTH; i++) {
+		stack[i] = -1;
+	}
+	numOfEntries = 0;
+}
@@ -0,0 +1,83 @@
+#include <string.h>
+
+#include "FixedHeapPage.h"
+
+
+//--------------------------------------------------------------------
+// FixedHeapPage::Capacity
+//
+// Input   :  recLen - The length of the records.
+// Return  :  The # of records that fit on a page with their bitmap. Never
+//            more than a HeapPage can hold, so that readers can size
+//            their buffers for HeapPage.
+//--------------------------------------------------------------------
+int FixedHeapPage::Capacity(int recLen) {
+	int n = (HEAPPAGE_DATA_SIZE * 8) / (recLen * 8 + 1);
+	while (n > 0 && n * recLen + (n + 7) / 8 > HEAPPAGE_DATA_SIZE) {
+		n--;
+	}
+
+	int maxSlots = HEAPPAGE_DATA_SIZE / (2 * (int)sizeof(short));
+	return n < maxSlots ? n : maxSlots;
+}
+
+//--------------------------------------------------------------------
+// FixedHeapPage::Init
+//
+// Input   :  pageNo - The PageID of this page.
+//            recLen - The length of the records the page will hold.
+//--------------------------------------------------------------------
+void FixedHeapPage::Init(PageID pageNo, int recLen) {
+	HeapPage::Init(pageNo);
+	type = FIXED_PAGE_TYPE;
+	freePtr = recLen;
+	freeSpace = Capacity(recLen);
+	numOfSlots = 0;
+	memset(data, 0, BitmapSize());
+}
+
+//--------------------------------------------------------------------
+// FixedHeapPage::InsertRecord
+//
+// Input   :  recPtr - The record to insert.
+//            recLen - Its length, which must be the page's record length.
+// Output  :  rid    - The RecordID of the new record.
+// Return  :  OK, or DONE if the page is full, FAIL if recLen is wrong.
+//--------------------------------------------------------------------
+Status FixedHeapPage::InsertRecord(const char* recPtr, int recLen, RecordID& rid) {
+	if (recLen != freePtr) return FAIL;
+	if (numOfSlots == freeSpace) return DONE;
+
+	int pos = numOfSlots++;
+	data[pos >> 3] |= (char)(1 << (pos & 7));
+	memcpy(GetRecordPointer(pos), recPtr, recLen);
+
+	rid.pageNo = pid;
+	rid.slotNo = pos;
+	return OK;
+}
+
+Status FixedHeapPage::DeleteRecord(RecordID rid) {
+	if (rid.slotNo < 0 || rid.slotNo >= numOfSlots || !IsUsed(rid.slotNo)) {
+		return FAIL;
+	}
+	data[rid.slotNo >> 3] &= (char)~(1 << (rid.slotNo & 7));
+	return OK;
+}
+
+Status FixedHeapPage::ReturnRecord(RecordID rid, char*& recPtr, int& len) {
+	if (rid.slotNo < 0 || rid.slotNo >= numOfSlots || !IsUsed(rid.slotNo)) {
+		return FAIL;
+	}
+	recPtr = GetRecordPointer(rid.slotNo);
+	len = freePtr;
+	return OK;
+}
+
+int FixedHeapPage::GetNumOfRecords() {
+	int n = 0;
+	for (int i = 0; i < numOfSlots; i++) {
+		if (IsUsed(i)) n++;
+	}
+	return n;
+}
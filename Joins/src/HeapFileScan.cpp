@@ -0,0 +1,617 @@
+#include "HeapFileScan.h"
+#include "FixedHeapPage.h"
+#include "PaxHeapPage.h"
+#include "PackedHeapPage.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "BufStats.h"
+
+
+//--------------------------------------------------------------------
+// HeapFileScan::HeapFileScan
+//
+// Input   :  file     - The HeapFile to scan.
+//            backward - True to visit the pages from last to first.
+//            useRing  - True to read the data pages into frames owned by
+//                       the scan instead of the buffer pool.
+// Output  :  status   - OK if the directory page the scan starts from
+//                       could be pinned, FAIL otherwise.
+//--------------------------------------------------------------------
+HeapFileScan::HeapFileScan(HeapFile* file, Status& status, bool backward,
+	                       bool useRing) {
+	this->file = file;
+	this->backward = backward;
+	currEntry = 0;
+	aheadCount = 0;
+	aheadPos = 0;
+	currPid = INVALID_PAGE;
+	page = NULL;
+	pageType = SLOTTED_PAGE_TYPE;
+	formattedFile = false;
+
+	recs = new char*[MAX_RECORDS_PER_PAGE];
+	lens = new short[MAX_RECORDS_PER_PAGE];
+	rids = new RecordID[MAX_RECORDS_PER_PAGE];
+	rows = NULL;
+	rowsSize = 0;
+	keys = new int[MAX_RECORDS_PER_PAGE];
+	numOfRecs = 0;
+	rowsLoaded = true;
+	pos = 0;
+	noMore = false;
+	numOfPagesRead = 0;
+	ring = NULL;
+	zones = NULL;
+	buildZones = false;
+	keyLow = 0;
+	keyHigh = 0;
+	if (useRing) {
+		// The database must hold the latest version of every page
+		MINIBASE_BM->FlushAllPages();
+		ring = new Page[READ_AHEAD_PAGES];
+	}
+
+	dirPid = file->GetFirstDirPage();
+	if (MINIBASE_BM->PinPage(dirPid, (Page *&)dirPage) != OK) {
+		std::cerr << "Unable to pin page " << dirPid << std::endl;
+		dirPage = NULL;
+		noMore = true;
+		status = FAIL;
+		return;
+	}
+
+	if (backward) {
+		// Start from the last entry of the last directory page
+		while (dirPage->GetNextPage() != INVALID_PAGE) {
+			PageID next = dirPage->GetNextPage();
+			MINIBASE_BM->UnpinPage(dirPid, CLEAN);
+			dirPid = next;
+			if (MINIBASE_BM->PinPage(dirPid, (Page *&)dirPage) != OK) {
+				std::cerr << "Unable to pin page " << dirPid << std::endl;
+				dirPage = NULL;
+				noMore = true;
+				status = FAIL;
+				return;
+			}
+		}
+		currEntry = dirPage->numOfEntry - 1;
+	}
+	status = OK;
+}
+
+HeapFileScan::~HeapFileScan() {
+	Release();
+	delete [] recs;
+	delete [] lens;
+	delete [] rids;
+	delete [] rows;
+	delete [] keys;
+	delete [] ring;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::Release
+//
+// Purpose :  Unpins the current data and directory pages, and the pages
+//            read ahead.
+//--------------------------------------------------------------------
+void HeapFileScan::Release() {
+	DropReadAhead();
+	if (page != NULL) {
+		ReleasePage(currPid);
+		page = NULL;
+		currPid = INVALID_PAGE;
+	}
+	if (dirPage != NULL) {
+		MINIBASE_BM->UnpinPage(dirPid, CLEAN);
+		dirPage = NULL;
+	}
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::LoadPage
+//
+// Purpose :  Collects the records of the current data page by walking
+//            its slot array, or its bitmap if it is a FixedHeapPage, once.
+//            Only the RecordIDs of a PaxHeapPage or PackedHeapPage are
+//            collected.
+//--------------------------------------------------------------------
+void HeapFileScan::LoadPage() {
+	int n = 0;
+	rowsLoaded = true;
+	if (pageType == PAX_PAGE_TYPE || pageType == PACKED_PAGE_TYPE) {
+		// Records are gathered by LoadRows if needed. Both pages keep the
+		// # of attributes in freePtr and the # of records in numOfSlots.
+		int len = page->freePtr * sizeof(int);
+		for (; n < page->numOfSlots; n++) {
+			lens[n] = len;
+			rids[n].pageNo = currPid;
+			rids[n].slotNo = n;
+		}
+		numOfRecs = n;
+		pos = 0;
+		rowsLoaded = false;
+		return;
+	}
+
+	if (pageType == FIXED_PAGE_TYPE) {
+		// Walk the bitmap instead
+		FixedHeapPage *fixed = (FixedHeapPage *)page;
+		int len = fixed->GetRecLen();
+		for (int i = 0; i < fixed->GetNumOfPositions(); i++) {
+			if (!fixed->IsUsed(i)) continue;
+			recs[n] = fixed->GetRecordPointer(i);
+			lens[n] = len;
+			rids[n].pageNo = currPid;
+			rids[n].slotNo = i;
+			n++;
+		}
+		numOfRecs = n;
+		pos = 0;
+		return;
+	}
+
+	HeapPage::Slot *slot = page->GetFirstSlotPointer();
+	for (int i = 0; i < page->numOfSlots; i++, slot--) {
+		if (page->SlotIsEmpty(slot)) continue;
+		recs[n] = page->data + slot->offset;
+		lens[n] = slot->length;
+		rids[n].pageNo = currPid;
+		rids[n].slotNo = i;
+		n++;
+	}
+	numOfRecs = n;
+	pos = 0;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::FetchPage
+//
+// Purpose :  Pins data page pid, or reads it into frame of the ring.
+//--------------------------------------------------------------------
+Status HeapFileScan::FetchPage(PageID pid, int frame, HeapPage*& dataPage) {
+	if (ring == NULL) {
+		PIN(pid, dataPage);
+		return OK;
+	}
+
+	if (MINIBASE_DB->ReadPage(pid, ring + frame) != OK) {
+		std::cerr << "Unable to read page " << pid << std::endl;
+		return FAIL;
+	}
+	BufStats::AddReads(1);
+	dataPage = (HeapPage *)(ring + frame);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::ReleasePage
+//
+// Purpose :  Unpins data page pid. Ring frames need no release.
+//--------------------------------------------------------------------
+Status HeapFileScan::ReleasePage(PageID pid) {
+	if (ring == NULL) {
+		UNPIN(pid, CLEAN);
+	}
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::LoadRows
+//
+// Purpose :  Gathers the records of the current PaxHeapPage or
+//            PackedHeapPage into rows, one column at a time, and points
+//            recs at them.
+//--------------------------------------------------------------------
+void HeapFileScan::LoadRows() {
+	if (rowsLoaded) return;
+
+	int len = page->freePtr * sizeof(int);
+	int numOfAttr = page->freePtr;
+	if (numOfRecs * len > rowsSize) {
+		// A PackedHeapPage may hold more than a page worth of records
+		delete [] rows;
+		rowsSize = MAX_RECORDS_PER_PAGE * len;
+		rows = new char[rowsSize];
+	}
+
+	for (int a = 0; a < numOfAttr; a++) {
+		int *col;
+		if (pageType == PAX_PAGE_TYPE) {
+			col = ((PaxHeapPage *)page)->Column(a);
+		}
+		else {
+			((PackedHeapPage *)page)->Unpack(a, keys);
+			col = keys;
+		}
+		int *attr = (int *)rows + a;
+		for (int i = 0; i < numOfRecs; i++, attr += numOfAttr) {
+			*attr = col[i];
+		}
+	}
+	for (int i = 0; i < numOfRecs; i++) {
+		recs[i] = rows + i * len;
+	}
+	rowsLoaded = true;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::PinDataPage
+//
+// Purpose :  Replaces the current data page with page pid and loads it.
+//--------------------------------------------------------------------
+Status HeapFileScan::PinDataPage(PageID pid, bool formatted) {
+	if (page != NULL) {
+		page = NULL;
+		if (ReleasePage(currPid) != OK) return FAIL;
+	}
+	numOfRecs = 0;
+	pos = 0;
+
+	currPid = pid;
+	if (FetchPage(currPid, 0, page) != OK) {
+		page = NULL;
+		return FAIL;
+	}
+	pageType = PageType(page, formatted);
+	LoadPage();
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::ReadAhead
+//
+// Purpose :  Collects the next READ_AHEAD_PAGES data pages with records
+//            from the directory, in the direction of the scan, and pins
+//            them in ascending PageID order. Leaves aheadCount at 0 at
+//            the end of the file.
+//--------------------------------------------------------------------
+Status HeapFileScan::ReadAhead() {
+	aheadCount = 0;
+	aheadPos = 0;
+	while (aheadCount < READ_AHEAD_PAGES) {
+		PageInfo *info = currEntry < 0 ? NULL : dirPage->GetPageInfo(currEntry);
+		if (info == NULL) {
+			// End of this directory page
+			PageID next = backward ? dirPage->prev : dirPage->GetNextPage();
+			if (next == INVALID_PAGE) break;
+
+			dirPage = NULL;
+			UNPIN(dirPid, CLEAN);
+			dirPid = next;
+			PIN(dirPid, dirPage);
+			currEntry = backward ? dirPage->numOfEntry - 1 : 0;
+			continue;
+		}
+		currEntry += backward ? -1 : 1;
+		bool formatted = info->spaceAvailable == FORMATTED_PAGE_SPACE;
+		if (formatted) formattedFile = true;
+
+		// Don't bother pinning pages without records, or without records
+		// in the key range
+		if (info->numOfRecords == 0) continue;
+		if (zones != NULL && !buildZones && !zones->MayContain(info->pid, keyLow, keyHigh)) {
+			continue;
+		}
+		aheadFormatted[aheadCount] = formatted;
+		ahead[aheadCount++] = info->pid;
+	}
+
+	// Sort the pins by PageID, the pages are still read in directory order
+	int order[READ_AHEAD_PAGES];
+	for (int i = 0; i < aheadCount; i++) {
+		int j = i;
+		for (; j > 0 && ahead[order[j - 1]] > ahead[i]; j--) {
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+	}
+
+	for (int i = 0; i < aheadCount; i++) {
+		PageID pid = ahead[order[i]];
+		if (FetchPage(pid, order[i], aheadPages[order[i]]) != OK) {
+			for (int j = 0; j < i; j++) {
+				ReleasePage(ahead[order[j]]);
+			}
+			aheadCount = 0;
+			return FAIL;
+		}
+	}
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::DropReadAhead
+//
+// Purpose :  Unpins the pages read ahead that were not used.
+//--------------------------------------------------------------------
+void HeapFileScan::DropReadAhead() {
+	for (; aheadPos < aheadCount; aheadPos++) {
+		ReleasePage(ahead[aheadPos]);
+	}
+	aheadCount = 0;
+	aheadPos = 0;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::NextDataPage
+//
+// Purpose :  Moves to the next data page with records, following the
+//            directory. Sets noMore at the end of the file.
+//--------------------------------------------------------------------
+Status HeapFileScan::NextDataPage() {
+	if (page != NULL) {
+		page = NULL;
+		if (ReleasePage(currPid) != OK) return FAIL;
+	}
+	numOfRecs = 0;
+	pos = 0;
+
+	while (true) {
+		if (aheadPos == aheadCount) {
+			if (ReadAhead() != OK) return FAIL;
+			if (aheadCount == 0) {
+				noMore = true;
+				return OK;
+			}
+		}
+
+		// The page is already pinned
+		currPid = ahead[aheadPos];
+		page = aheadPages[aheadPos];
+		pageType = PageType(page, aheadFormatted[aheadPos]);
+		aheadPos++;
+
+		LoadPage();
+		if (numOfRecs > 0) {
+			numOfPagesRead++;
+			if (buildZones) {
+				int *pageKeys = PageKeys(zones->GetOffset());
+				int min = pageKeys[0];
+				int max = pageKeys[0];
+				for (int i = 1; i < numOfRecs; i++) {
+					if (pageKeys[i] < min) min = pageKeys[i];
+					if (pageKeys[i] > max) max = pageKeys[i];
+				}
+				zones->Add(currPid, min, max);
+			}
+			return OK;
+		}
+
+		page = NULL;
+		if (ReleasePage(currPid) != OK) return FAIL;
+	}
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::GetNext
+//
+// Output  :  rid    - The RecordID of the next record.
+//            recPtr - Points to the record inside the pinned page.
+//            recLen - The length of the record.
+// Return  :  OK, DONE at the end of the file, FAIL on error.
+//--------------------------------------------------------------------
+Status HeapFileScan::GetNext(RecordID& rid, char*& recPtr, int& recLen) {
+	while (pos == numOfRecs) {
+		if (noMore) return DONE;
+		if (NextDataPage() != OK) return FAIL;
+	}
+	LoadRows();
+
+	rid = rids[pos];
+	recPtr = recs[pos];
+	recLen = lens[pos];
+	pos++;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::NextPage
+//
+// Output  :  recPtrs   - Pointers to the records of the page.
+//            rids      - The RecordIDs of the records.
+//            numOfRecs - The # of records returned, at least 1.
+// Return  :  OK, DONE at the end of the file, FAIL on error.
+//--------------------------------------------------------------------
+Status HeapFileScan::NextPage(char**& recPtrs, RecordID*& rids, int& numOfRecs) {
+	while (pos == this->numOfRecs) {
+		if (noMore) return DONE;
+		if (NextDataPage() != OK) return FAIL;
+	}
+	LoadRows();
+
+	recPtrs = recs + pos;
+	rids = this->rids + pos;
+	numOfRecs = this->numOfRecs - pos;
+	pos = this->numOfRecs;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::NextPageKeys
+//
+// Input   :  offset    - Offset of the integer attribute to return.
+// Output  :  keys      - The attribute of each record.
+//            rids      - The RecordIDs of the records.
+//            numOfRecs - The # of records returned, at least 1.
+// Return  :  OK, DONE at the end of the file, FAIL on error.
+//--------------------------------------------------------------------
+Status HeapFileScan::NextPageKeys(int offset, int*& keys, RecordID*& rids, int& numOfRecs) {
+	while (pos == this->numOfRecs) {
+		if (noMore) return DONE;
+		if (NextDataPage() != OK) return FAIL;
+	}
+
+	keys = PageKeys(offset) + pos;
+	rids = this->rids + pos;
+	numOfRecs = this->numOfRecs - pos;
+	pos = this->numOfRecs;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::PageKeys
+//
+// Input   :  offset - Offset of an integer attribute.
+// Return  :  The attribute of every record of the current page, in slot
+//            order. Points into the page for a PaxHeapPage and to keys
+//            otherwise.
+//--------------------------------------------------------------------
+int* HeapFileScan::PageKeys(int offset) {
+	if (pageType == PAX_PAGE_TYPE) {
+		return ((PaxHeapPage *)page)->Column(offset / sizeof(int));
+	}
+	if (pageType == PACKED_PAGE_TYPE) {
+		((PackedHeapPage *)page)->Unpack(offset / sizeof(int), keys);
+		return keys;
+	}
+	for (int i = 0; i < numOfRecs; i++) {
+		keys[i] = *(int *)(recs[i] + offset);
+	}
+	return keys;
+}
+
+void HeapFileScan::SetKeyRange(ZoneMap* zones, int low, int high) {
+	this->zones = zones;
+	buildZones = false;
+	keyLow = low;
+	keyHigh = high;
+}
+
+void HeapFileScan::BuildZoneMap(ZoneMap* zones) {
+	this->zones = zones;
+	buildZones = true;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::MoveTo
+//
+// Input   :  rid - A record of the file.
+// Return  :  OK if the next call to GetNext will return rid, FAIL if rid
+//            is not a record of the file.
+//--------------------------------------------------------------------
+Status HeapFileScan::MoveTo(RecordID rid) {
+	if (dirPage == NULL) return FAIL;
+
+	if (page == NULL || rid.pageNo != currPid) {
+		DropReadAhead();
+
+		// Look in the current directory page first, then from the start
+		int entry = dirPage->FindPageInfoEntry(rid.pageNo);
+		if (entry < 0) {
+			dirPage = NULL;
+			UNPIN(dirPid, CLEAN);
+			dirPid = file->GetFirstDirPage();
+			while (true) {
+				PIN(dirPid, dirPage);
+				entry = dirPage->FindPageInfoEntry(rid.pageNo);
+				if (entry >= 0) break;
+
+				PageID next = dirPage->GetNextPage();
+				if (next == INVALID_PAGE) {
+					std::cerr << "Page " << rid.pageNo << " is not part of the file." << std::endl;
+					return FAIL;
+				}
+				dirPage = NULL;
+				UNPIN(dirPid, CLEAN);
+				dirPid = next;
+			}
+		}
+
+		currEntry = backward ? entry - 1 : entry + 1;
+		PageInfo *info = dirPage->GetPageInfo(entry);
+		if (PinDataPage(rid.pageNo, info->spaceAvailable == FORMATTED_PAGE_SPACE) != OK) {
+			return FAIL;
+		}
+	}
+
+	for (pos = 0; pos < numOfRecs; pos++) {
+		if (rids[pos].slotNo == rid.slotNo) {
+			noMore = false;
+			return OK;
+		}
+	}
+	std::cerr << "Record " << rid.pageNo << "." << rid.slotNo
+		      << " is not part of the file." << std::endl;
+	return FAIL;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::ExceedsPool
+//
+// Input   :  file - A HeapFile.
+// Return  :  True if file has more data pages than the buffer pool has
+//            frames. The pages are counted in the directory, so this
+//            holds for every page format.
+//--------------------------------------------------------------------
+bool HeapFileScan::ExceedsPool(HeapFile* file) {
+	return CountPages(file) > (int)MINIBASE_BM->GetNumOfBuffers();
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::CountPages
+//
+// Input   :  file - A HeapFile.
+// Return  :  The # of data pages entered in the directory of file, or
+//            -1 if a directory page could not be pinned.
+//--------------------------------------------------------------------
+int HeapFileScan::CountPages(HeapFile* file) {
+	int n = 0;
+	PageID pid = file->GetFirstDirPage();
+	while (pid != INVALID_PAGE) {
+		DirPage *dir;
+		if (MINIBASE_BM->PinPage(pid, (Page *&)dir) != OK) {
+			std::cerr << "Unable to pin page " << pid << std::endl;
+			return -1;
+		}
+		n += dir->numOfEntry;
+		PageID next = dir->GetNextPage();
+		MINIBASE_BM->UnpinPage(pid, CLEAN);
+		pid = next;
+	}
+	return n;
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::ReturnRecord
+//
+// Input   :  page   - A pinned data page of any format.
+//            rid    - A record on the page.
+//            buf    - Room for a copy of the record.
+//            formatted - False if the page is a HeapPage, whatever its
+//                     type says.
+// Output  :  recPtr - Points to the record inside the page, or to buf
+//                     for a PaxHeapPage or PackedHeapPage.
+//            len    - The length of the record.
+// Return  :  OK, or FAIL if rid is not a record of the page.
+//--------------------------------------------------------------------
+Status HeapFileScan::ReturnRecord(HeapPage* page, RecordID rid, char*& recPtr, int& len,
+	                              char* buf, bool formatted) {
+	short type = PageType(page, formatted);
+	if (type == PAX_PAGE_TYPE) {
+		recPtr = buf;
+		return ((PaxHeapPage *)page)->GetRecord(rid, buf, len);
+	}
+	if (type == PACKED_PAGE_TYPE) {
+		recPtr = buf;
+		return ((PackedHeapPage *)page)->GetRecord(rid, buf, len);
+	}
+	if (type == FIXED_PAGE_TYPE) {
+		return ((FixedHeapPage *)page)->ReturnRecord(rid, recPtr, len);
+	}
+	return page->ReturnRecord(rid, recPtr, len);
+}
+
+//--------------------------------------------------------------------
+// HeapFileScan::PageType
+//
+// Input   :  page      - A data page.
+//            formatted - True if the directory entry of the page holds
+//                        FORMATTED_PAGE_SPACE.
+// Return  :  The layout of the page. The type of other pages is not set
+//            by the library, so they are taken to be HeapPages.
+//--------------------------------------------------------------------
+short HeapFileScan::PageType(HeapPage* page, bool formatted) {
+	if (!formatted) return SLOTTED_PAGE_TYPE;
+	return page->type;
+}
@@ -0,0 +1,380 @@
+#include "HeapFileWriter.h"
+#include "bufmgr.h"
+#include "db.h"
+
+
+//--------------------------------------------------------------------
+// HeapFileWriter::HeapFileWriter
+//
+// Input   :  file        - The HeapFile to append to.
+//            format      - The layout of the data pages to fill.
+// Output  :  status      - OK if the last directory page of the file
+//                          could be pinned, FAIL otherwise, or if the
+//                          format is not SLOTTED_PAGES and the file is
+//                          not empty.
+//--------------------------------------------------------------------
+HeapFileWriter::HeapFileWriter(HeapFile* file, Status& status, PageFormat format) {
+	this->file = file;
+	this->format = format;
+	recLen = 0;
+	dirPage = NULL;
+	currPid = INVALID_PAGE;
+	currPage = NULL;
+	currRecords = 0;
+	numOfRecords = 0;
+	numOfPages = 0;
+	nextPid = INVALID_PAGE;
+	numOfFreePages = 0;
+	extentSize = WRITER_RUN_SIZE;
+	numOfDirty = 0;
+	packRows = NULL;
+	packMin = NULL;
+	packMax = NULL;
+	packWidths = NULL;
+	zones = NULL;
+	keyMin = 0;
+	keyMax = 0;
+
+	// Find the last directory page
+	dirPid = file->GetFirstDirPage();
+	if (MINIBASE_BM->PinPage(dirPid, (Page *&)dirPage) != OK) {
+		std::cerr << "Unable to pin page " << dirPid << std::endl;
+		dirPage = NULL;
+		status = FAIL;
+		return;
+	}
+	if (format != SLOTTED_PAGES &&
+		(!dirPage->IsEmpty() || dirPage->GetNextPage() != INVALID_PAGE)) {
+		// Random reads go by the format of the whole file
+		std::cerr << "Only an empty HeapFile can be given pages of another format." << std::endl;
+		MINIBASE_BM->UnpinPage(dirPid, CLEAN);
+		dirPage = NULL;
+		status = FAIL;
+		return;
+	}
+	while (dirPage->GetNextPage() != INVALID_PAGE) {
+		PageID next = dirPage->GetNextPage();
+		MINIBASE_BM->UnpinPage(dirPid, CLEAN);
+		dirPid = next;
+		if (MINIBASE_BM->PinPage(dirPid, (Page *&)dirPage) != OK) {
+			std::cerr << "Unable to pin page " << dirPid << std::endl;
+			dirPage = NULL;
+			status = FAIL;
+			return;
+		}
+	}
+	file->lastDirPid = dirPid;
+	status = OK;
+}
+
+HeapFileWriter::~HeapFileWriter() {
+	Close();
+	delete [] packRows;
+	delete [] packMin;
+	delete [] packMax;
+	delete [] packWidths;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::NextDataPage
+//
+// Purpose :  Pins the next unused data page, allocating a new extent
+//            if the current one is used up, and initializes it.
+//--------------------------------------------------------------------
+Status HeapFileWriter::NextDataPage() {
+	if (numOfFreePages == 0) {
+		// NewPage pins the first page of the extent. Without enough
+		// contiguous space, try smaller extents down to a single page.
+		int size = extentSize;
+		while (size > 1 && MINIBASE_BM->NewPage(currPid, (Page *&)currPage, size) != OK) {
+			size /= 2;
+		}
+		if (size == 1) {
+			NEWPAGE(currPid, currPage);
+		}
+		nextPid = currPid + 1;
+		numOfFreePages = size - 1;
+
+		if (extentSize < WRITER_MAX_EXTENT) {
+			extentSize *= 2;
+		}
+	}
+	else {
+		currPid = nextPid;
+		if (MINIBASE_BM->PinPage(currPid, (Page *&)currPage, true) != OK) {
+			std::cerr << "Unable to pin page " << currPid << std::endl;
+			currPage = NULL;
+			return FAIL;
+		}
+		nextPid++;
+		numOfFreePages--;
+	}
+
+	if (format == FIXED_PAGES) {
+		((FixedHeapPage *)currPage)->Init(currPid, recLen);
+	}
+	else if (format == PAX_PAGES) {
+		((PaxHeapPage *)currPage)->Init(currPid, recLen);
+	}
+	else if (format == PACKED_PAGES) {
+		// Written by FinishPage, once all its records are known
+	}
+	else {
+		currPage->Init(currPid);
+		currPage->type = SLOTTED_PAGE_TYPE;
+	}
+	currRecords = 0;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::FinishPage
+//
+// Purpose :  Enters the current data page into the last directory page,
+//            adding a directory page first if it is full, and queues it
+//            to be released.
+//--------------------------------------------------------------------
+Status HeapFileWriter::FinishPage() {
+	if (format == PACKED_PAGES) {
+		int numOfAttr = recLen / sizeof(int);
+		for (int a = 0; a < numOfAttr; a++) {
+			packWidths[a] = PackedHeapPage::Width(packMin[a], packMax[a]);
+		}
+		((PackedHeapPage *)currPage)->Pack(currPid, packRows, currRecords, numOfAttr,
+		                                   packMin, packWidths);
+	}
+
+	if (!dirPage->HasFreeSpace()) {
+		PageID newPid;
+		DirPage *newPage;
+		NEWPAGE(newPid, newPage);
+		newPage->Init(newPid);
+		newPage->SetPrevPage(dirPid);
+		dirPage->SetNextPage(newPid);
+		UNPIN(dirPid, DIRTY);
+
+		dirPid = newPid;
+		dirPage = newPage;
+		file->lastDirPid = dirPid;
+	}
+
+	dirPage->InsertPage(currPid, currPage);
+	PageInfo *info = dirPage->FindPageInfo(currPid);
+	info->numOfRecords = currRecords;
+	if (zones != NULL && currRecords > 0) {
+		zones->Add(currPid, keyMin, keyMax);
+	}
+	if (format != SLOTTED_PAGES) {
+		// Tells readers to go by HeapPage::type, and keeps
+		// HeapFile::InsertRecord from adding to the page
+		info->spaceAvailable = FORMATTED_PAGE_SPACE;
+	}
+	numOfRecords += currRecords;
+	numOfPages++;
+
+	dirtyPids[numOfDirty++] = currPid;
+	currPage = NULL;
+	currPid = INVALID_PAGE;
+	if (numOfDirty == WRITER_RUN_SIZE) return ReleaseDirty();
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::ReleaseDirty
+//
+// Purpose :  Unpins the finished data pages, dirty, in ascending PageID
+//            order. They are written back when the pool evicts them, in
+//            the same order, or never if the file is deleted first, as
+//            temp files often are.
+//--------------------------------------------------------------------
+Status HeapFileWriter::ReleaseDirty() {
+	for (int i = 1; i < numOfDirty; i++) {
+		PageID pid = dirtyPids[i];
+		int j = i;
+		for (; j > 0 && dirtyPids[j - 1] > pid; j--) {
+			dirtyPids[j] = dirtyPids[j - 1];
+		}
+		dirtyPids[j] = pid;
+	}
+
+	Status s = OK;
+	for (int i = 0; i < numOfDirty; i++) {
+		if (MINIBASE_BM->UnpinPage(dirtyPids[i], DIRTY) != OK) {
+			std::cerr << "Unable to unpin page " << dirtyPids[i] << std::endl;
+			s = FAIL;
+		}
+	}
+	numOfDirty = 0;
+	return s;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::Append
+//
+// Input   :  recPtr - The record to append.
+//            recLen - The length of the record.
+// Output  :  outRid - The RecordID of the new record.
+// Return  :  OK if the record was appended, FAIL otherwise.
+//--------------------------------------------------------------------
+Status HeapFileWriter::Append(const char* recPtr, int recLen, RecordID& outRid) {
+	if (dirPage == NULL) return FAIL;
+
+	if (format != SLOTTED_PAGES) {
+		if (this->recLen == 0) {
+			if ((format == PAX_PAGES || format == PACKED_PAGES) && recLen % sizeof(int) != 0) {
+				std::cerr << "Record of length " << recLen << " is not made of integers." << std::endl;
+				return FAIL;
+			}
+			this->recLen = recLen;
+		}
+		else if (recLen != this->recLen) {
+			std::cerr << "Record of length " << recLen << " in a file of records of length "
+				      << this->recLen << "." << std::endl;
+			return FAIL;
+		}
+	}
+
+	if (format == PACKED_PAGES) return AppendPacked(recPtr, outRid);
+
+	if (currPage != NULL && AvailableSpace() < recLen) {
+		if (FinishPage() != OK) return FAIL;
+	}
+	if (currPage == NULL) {
+		if (NextDataPage() != OK) return FAIL;
+	}
+
+	Status s;
+	if (format == FIXED_PAGES) 
+		s = ((FixedHeapPage *)currPage)->InsertRecord(recPtr, recLen, outRid);
+	else if (format == PAX_PAGES)
+		s = ((PaxHeapPage *)currPage)->InsertRecord(recPtr, recLen, outRid);
+	else
+		s = currPage->InsertRecord(recPtr, recLen, outRid);
+	if (s != OK) {
+		std::cerr << "Record of length " << recLen << " does not fit on a page." << std::endl;
+		return FAIL;
+	}
+	AddKey(recPtr);
+	currRecords++;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::AddKey
+//
+// Purpose :  Widens the key range of the current page by the key of the
+//            record at recPtr, which is about to be counted on the page.
+//--------------------------------------------------------------------
+void HeapFileWriter::AddKey(const char* recPtr) {
+	if (zones == NULL) return;
+
+	int key = *(const int *)(recPtr + zones->GetOffset());
+	if (currRecords == 0 || key < keyMin) keyMin = key;
+	if (currRecords == 0 || key > keyMax) keyMax = key;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::AvailableSpace
+//
+// Return  :  The space left for records on the current page.
+//--------------------------------------------------------------------
+int HeapFileWriter::AvailableSpace() {
+	if (format == FIXED_PAGES) return ((FixedHeapPage *)currPage)->AvailableSpace();
+	if (format == PAX_PAGES) return ((PaxHeapPage *)currPage)->AvailableSpace();
+	return currPage->AvailableSpace();
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::AppendPacked
+//
+// Purpose :  Adds a record to the records of the current PackedHeapPage,
+//            finishing the page first if the record would not fit.
+// Input   :  recPtr - The record to append, of length recLen.
+// Output  :  outRid - The RecordID of the new record.
+//--------------------------------------------------------------------
+Status HeapFileWriter::AppendPacked(const char* recPtr, RecordID& outRid) {
+	int numOfAttr = recLen / sizeof(int);
+	if (packRows == NULL) {
+		packRows = new int[PackedHeapPage::MaxRecords() * numOfAttr];
+		packMin = new int[numOfAttr];
+		packMax = new int[numOfAttr];
+		packWidths = new int[numOfAttr];
+	}
+
+	if (currPage != NULL && !PackFits(recPtr)) {
+		if (FinishPage() != OK) return FAIL;
+	}
+	if (currPage == NULL) {
+		if (NextDataPage() != OK) return FAIL;
+		if (!PackFits(recPtr)) {
+			std::cerr << "Record of length " << recLen << " does not fit on a page." << std::endl;
+			return FAIL;
+		}
+	}
+
+	const int *attrs = (const int *)recPtr;
+	int *row = packRows + currRecords * numOfAttr;
+	for (int a = 0; a < numOfAttr; a++) {
+		row[a] = attrs[a];
+		if (currRecords == 0 || attrs[a] < packMin[a]) packMin[a] = attrs[a];
+		if (currRecords == 0 || attrs[a] > packMax[a]) packMax[a] = attrs[a];
+	}
+
+	outRid.pageNo = currPid;
+	outRid.slotNo = currRecords;
+	AddKey(recPtr);
+	currRecords++;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// HeapFileWriter::PackFits
+//
+// Return  :  True if the current PackedHeapPage can hold its records and
+//            the one at recPtr.
+//--------------------------------------------------------------------
+bool HeapFileWriter::PackFits(const char* recPtr) {
+	if (currRecords == PackedHeapPage::MaxRecords()) return false;
+
+	int numOfAttr = recLen / sizeof(int);
+	const int *attrs = (const int *)recPtr;
+	for (int a = 0; a < numOfAttr; a++) {
+		int min = attrs[a];
+		int max = attrs[a];
+		if (currRecords > 0) {
+			if (packMin[a] < min) min = packMin[a];
+			if (packMax[a] > max) max = packMax[a];
+		}
+		packWidths[a] = PackedHeapPage::Width(min, max);
+	}
+	return PackedHeapPage::Size(numOfAttr, currRecords + 1, packWidths) <= HEAPPAGE_DATA_SIZE;
+}
+
+Status HeapFileWriter::Append(const char* recPtr, int recLen) {
+	RecordID rid;
+	return Append(recPtr, recLen, rid);
+}
+
+Status HeapFileWriter::Close() {
+	if (dirPage == NULL) return OK;
+
+	Status s = OK;
+	if (currPage != NULL && FinishPage() != OK) {
+		s = FAIL;
+	}
+	if (ReleaseDirty() != OK) {
+		s = FAIL;
+	}
+
+	if (numOfFreePages > 0) {
+		MINIBASE_DB->DeallocatePage(nextPid, numOfFreePages);
+		numOfFreePages = 0;
+	}
+
+	if (MINIBASE_BM->UnpinPage(dirPid, DIRTY) != OK) {
+		std::cerr << "Unable to unpin page " << dirPid << std::endl;
+		s = FAIL;
+	}
+	dirPage = NULL;
+	return s;
+}
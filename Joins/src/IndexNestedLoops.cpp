@@ -1,5 +1,7 @@
+#include <stdio.h>
+
 #include "join.h"
-#include "scan.h"
+#include "HeapFileScan.h"
 #include "bufmgr.h"
 #include "BTreeFile.h"
 #include "BTreeFileScan.h"
@@ -7,150 +9,259 @@
 //---------------------------------------------------------------
 // IndexNestedLoops::Execute
 //
-// Input:   left  - The left relation to join. 
-//          right - The right relation to join. 
-// Output:  out   - The relation to hold the ouptut. 
-// Return:  OK if join completed succesfully. FAIL otherwise. 
-//          
-// Purpose: Performs an index nested loops join on the specified relations. 
-// You should create a BTreeFile index on the join attribute of the right 
-// relation, and then probe it for each record in the left relation. Remember 
+// Input:   left  - The left relation to join.
+//          right - The right relation to join.
+// Output:  out   - The relation to hold the ouptut.
+// Return:  OK if join completed succesfully. FAIL otherwise.
+//
+// Purpose: Performs an index nested loops join on the specified relations.
+// You should create a BTreeFile index on the join attribute of the right
+// relation, and then probe it for each record in the left relation. Remember
 // that the BTree expects string keys, so you will have to convert the integer
-// attributes to a string using JoinMethod::toString. Note that the join may 
-// not be a foreign key join, so there may be multiple records indexed by the 
-// same key. Good thing our B-Tree supports this! Don't forget to destroy the 
-// BTree when you are done. 
+// attributes to a string using JoinMethod::toString. Note that the join may
+// not be a foreign key join, so there may be multiple records indexed by the
+// same key. Good thing our B-Tree supports this! Don't forget to destroy the
+// BTree when you are done.
 //---------------------------------------------------------------
 Status IndexNestedLoops::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	BufStatsScope scope("IndexNestedLoops");
 	JoinMethod::Execute(left, right, out);
 
-	// Make sure left relation is smaller, if not need to swap JoinSpecs
-	bool swapped = false;
-	if (left.file->GetNumOfRecords() > right.file->GetNumOfRecords()) {
-		JoinSpec tmp = left;
-		left = right;
-		right = tmp;
+	Iterator *it = CreateIterator(left, right);
+	Status s = Materialize(it, out);
+	delete it;
 
-		swapped = true;
+	return s;
+}
+
+//---------------------------------------------------------------
+// IndexNestedLoops::Pipeline
+//
+// Input:   left      - The left input to join.
+//          right     - The right input to join.
+//          leftSpec  - Describes the records produced by left.
+//          rightSpec - Describes the records produced by right.
+// Return:  A pipelined iterator over the join. When both inputs are
+//          stored relations, the smaller one is used as the outer
+//          relation; otherwise left is the outer relation.
+//---------------------------------------------------------------
+Iterator* IndexNestedLoops::Pipeline(Iterator* left, Iterator* right,
+	                                 JoinSpec& leftSpec, JoinSpec& rightSpec) {
+	// Make sure outer relation is smaller, if not need to swap inputs
+	if (leftSpec.file != NULL && rightSpec.file != NULL &&
+		leftSpec.GetNumOfRecords() > rightSpec.GetNumOfRecords()) {
+		return new IndexNestedLoopsIterator(right, left, rightSpec, leftSpec, true);
 	}
+	return new IndexNestedLoopsIterator(left, right, leftSpec, rightSpec, false);
+}
+
+
+// Used to give every index a distinct file name, so that several
+// iterators can be open at once.
+int IndexNestedLoopsIterator::numOfIndexes = 0;
+
+IndexNestedLoopsIterator::IndexNestedLoopsIterator(Iterator* outer, Iterator* inner,
+	                                               JoinSpec& outerSpec, JoinSpec& innerSpec,
+												   bool swapped)
+	: JoinIterator(outer, inner, outerSpec, innerSpec, swapped) {
+	bTree = NULL;
+	btScan = NULL;
+	innerTmp = NULL;
+	outerRec = NULL;
+	key = new char[MAX_KEY_LENGTH];
+	innerPid = INVALID_PAGE;
+	innerPage = NULL;
+	innerBuf = new char[innerSpec.recLen];
+	filter = NULL;
+	innerFormatted = false;
+	isOpen = false;
+}
+
+IndexNestedLoopsIterator::~IndexNestedLoopsIterator() {
+	// Drop the index file and the pinned page of an iterator still open
+	if (isOpen) Close();
+	delete [] key;
+	delete [] innerBuf;
+}
+
+//---------------------------------------------------------------
+// IndexNestedLoopsIterator::BuildFilter
+//
+// Purpose: Fills a Bloom filter with the join attribute of every
+//          record of the outer input, which must be stored.
+//---------------------------------------------------------------
+Status IndexNestedLoopsIterator::BuildFilter() {
+	// The outer input is stored, so no temp file is made
+	HeapFile *outerTmp;
+	HeapFile *outerFile = InputFile(outer, outerSpec, outerTmp);
 
-	// Create temporary heapfile
 	Status s;
-	HeapFile *tmpHeap = new HeapFile(NULL, s);
-	if (s != OK) {
-		std::cerr << "Failed to create output heapfile." << std::endl;
-		return FAIL;
-	}
-	
-	// Create BTreeFileIndex
-	BTreeFile *bTree = new BTreeFile(s, "BTREE");
+	HeapFileScan *outerScan = new HeapFileScan(outerFile, s);
 	if (s != OK) {
-		std::cerr << "Failed to create BTreeFile." << std::endl;
+		std::cerr << "Failed to open scan on outer relation." << std::endl;
+		delete outerScan;
 		return FAIL;
 	}
 
-	// Open scan on right relation
-	Status rightStatus;
-	Scan *rightScan = right.file->OpenScan(rightStatus);
-	if (rightStatus != OK) {
-		std::cerr << "Failed to open scan on right relation." << std::endl;
-		return FAIL;
+	filter = new BloomFilter(outerSpec.GetNumOfRecords());
+	int *outerKeys;
+	RecordID *outerRids;
+	int numOfRecs;
+	while ((s = outerScan->NextPageKeys(outerSpec.offset, outerKeys, outerRids, numOfRecs)) == OK) {
+		for (int i = 0; i < numOfRecs; i++) {
+			filter->Add(outerKeys[i]);
+		}
 	}
+	delete outerScan;
+	return s == DONE ? OK : FAIL;
+}
 
-	// Loop over right relation and fill btree
-	char *rightRec = new char[right.recLen];
-	while (true) {
-		RecordID rightRid;
-		rightStatus = rightScan->GetNext(rightRid, rightRec, right.recLen);
-		if (rightStatus == DONE) break;
-		if (rightStatus != OK) return FAIL;
-
-		// The join attribute on the righht relation.
-		int *rightJoinValPtr = (int*)(rightRec + right.offset);
-		
-		char *keyToInsert = new char[right.recLen+1];
-		this->toString(*rightJoinValPtr,keyToInsert);
-		bTree->Insert(keyToInsert, rightRid);
-	}
+//---------------------------------------------------------------
+// IndexNestedLoopsIterator::Open
+//
+// Purpose: Builds a BTreeFile index on the join attribute of the inner
+//          input and opens the outer input. The outer input is the
+//          smaller one; if it is stored, a Bloom filter of its keys is
+//          built first, and the inner records it rules out are left
+//          out of the index.
+//---------------------------------------------------------------
+Status IndexNestedLoopsIterator::Open() {
+	isOpen = true;
+	if (outer->GetFile() != NULL && BuildFilter() != OK) return FAIL;
 
-	delete rightScan;
+	HeapFile *innerFile = InputFile(inner, innerSpec, innerTmp);
+	if (innerFile == NULL) return FAIL;
 
-	// Open scan on left relation
-	Status leftStatus;
-	Scan *leftScan = left.file->OpenScan(leftStatus);
-	if (leftStatus != OK) {
-		std::cerr << "Failed to open scan on left relation" << std::endl;
-		return FAIL;
+	{
+		BufStatsScope scope("IndexBuild");
+
+		// Create BTreeFileIndex
+		Status s;
+		char indexName[MAX_KEY_LENGTH];
+		sprintf(indexName, "BTREE%d", numOfIndexes++);
+		bTree = new BTreeFile(s, indexName);
+		if (s != OK) {
+			std::cerr << "Failed to create BTreeFile." << std::endl;
+			return FAIL;
+		}
+
+		// Open scan on inner relation
+		Status innerStatus;
+		HeapFileScan *innerScan = new HeapFileScan(innerFile, innerStatus);
+		if (innerStatus != OK) {
+			std::cerr << "Failed to open scan on inner relation." << std::endl;
+			delete innerScan;
+			return FAIL;
+		}
+
+		// Loop over inner relation a page at a time and fill btree
+		int *innerKeys;
+		RecordID *innerRids;
+		int numOfRecs;
+		while ((innerStatus = innerScan->NextPageKeys(innerSpec.offset, innerKeys,
+			                                          innerRids, numOfRecs)) == OK) {
+			for (int i = 0; i < numOfRecs; i++) {
+				// The join attribute on the inner relation.
+				if (filter != NULL && !filter->MayContain(innerKeys[i])) continue;
+				JoinMethod::toString(innerKeys[i], key);
+				if (bTree->Insert(key, innerRids[i]) != OK) {
+					std::cerr << "Failed to insert into BTreeFile." << std::endl;
+					innerStatus = FAIL;
+					break;
+				}
+			}
+			if (innerStatus == FAIL) break;
+		}
+
+		innerFormatted = innerScan->HasFormattedPages();
+		delete innerScan;
+		if (innerStatus != DONE) {
+			std::cerr << "Failed to index the inner relation." << std::endl;
+			return FAIL;
+		}
 	}
 
-	// Loop over left relation
-	char *leftRec = new char[left.recLen];
+	outerRec = NULL;
+	return outer->Open();
+}
+
+//---------------------------------------------------------------
+// IndexNestedLoopsIterator::Next
+//
+// Purpose: Returns the next matching <outer, inner> pair. For every
+//          outer tuple, the index is probed for inner tuples with the
+//          same join attribute.
+//---------------------------------------------------------------
+Status IndexNestedLoopsIterator::Next(char*& recPtr) {
 	while (true) {
-		RecordID leftRid;
-		leftStatus = leftScan->GetNext(leftRid, leftRec, left.recLen);
-		if (leftStatus == DONE) break;
-		if (leftStatus != OK) return FAIL;
-
-		// Search btree for possible mathes on join attribute
-		int *leftJoinValPtr = (int*)(leftRec + left.offset);
-		char *key = new char[left.recLen + 1];
-		this->toString(*leftJoinValPtr, key);
-		BTreeFileScan *btScan = bTree->OpenScan(key, key);
-
-		// Loop through matched attributes
-		while (true) {
-			char *tmpKey = NULL;
-			RecordID rid;
-			Status bTreeStatus = btScan->GetNext(rid, tmpKey);
-			if (bTreeStatus == DONE) break;
-			if (bTreeStatus != OK) {
-				std::cerr << "Failed during scan." << std::endl;
-				return FAIL;
-			}
+		// Search btree for possible matches of the next outer tuple
+		if (btScan == NULL) {
+			Status outerStatus = outer->Next(outerRec);
+			if (outerStatus != OK) return outerStatus;
 
-			// Find page with matched rid and create new record
-			if (bTreeStatus == OK) {
-				Status searchStatus;
-				Page *hPage;
-				char *rightRec = new char[right.recLen];
-				PIN (rid.pageNo, hPage);
-				searchStatus = ((HeapPage*)hPage)->ReturnRecord(rid, rightRec, right.recLen);
-				// Btree gave a page that does not hold the given rid
-				if (searchStatus != OK) {
-					std::cerr << "BTree holds incorrect data." << std::endl;
-					UNPIN (rid.pageNo, CLEAN);
-					return FAIL;
-				}
-				// Create new record and insert into tmpHeap
-				char *joinedRec = new char[out.recLen];
-
-				// Need to check if JoinSpecs have been swapped
-					if (swapped) 
-						MakeNewRecord(joinedRec, rightRec, leftRec, right, left);
-					else
-						MakeNewRecord(joinedRec, leftRec, rightRec, left, right);
-
-				RecordID insertedRid;
-				Status tmpStatus = tmpHeap->InsertRecord(joinedRec, out.recLen, insertedRid);
-				if (tmpStatus != OK) {
-					std::cerr << "Failed to insert tuple into output heapfile." << std::endl;
-					UNPIN (rid.pageNo, CLEAN);
-					return FAIL;
-				}
+			int *outerJoinValPtr = (int*)(outerRec + outerSpec.offset);
+			JoinMethod::toString(*outerJoinValPtr, key);
+			btScan = bTree->OpenScan(key, key);
+		}
+
+		char *tmpKey = NULL;
+		RecordID rid;
+		Status bTreeStatus = btScan->GetNext(rid, tmpKey);
+		if (bTreeStatus == DONE) {
+			delete btScan;
+			btScan = NULL;
+			continue;
+		}
+		if (bTreeStatus != OK) {
+			std::cerr << "Failed during scan." << std::endl;
+			return FAIL;
+		}
 
-				delete [] joinedRec;
-				UNPIN (rid.pageNo, CLEAN);
+		// Find page with matched rid and create new record. Consecutive
+		// matches are often on the same page, so it stays pinned.
+		if (rid.pageNo != innerPid) {
+			if (innerPage != NULL) {
+				innerPage = NULL;
+				UNPIN (innerPid, CLEAN);
 			}
+			innerPid = rid.pageNo;
+			PIN (innerPid, innerPage);
 		}
 
-		delete btScan;
+		char *innerRec;
+		int len;
+		if (HeapFileScan::ReturnRecord(innerPage, rid, innerRec, len, innerBuf,
+			                             innerFormatted) != OK) {
+			// Btree gave a page that does not hold the given rid
+			std::cerr << "BTree holds incorrect data." << std::endl;
+			return FAIL;
+		}
+		recPtr = Join(outerRec, innerRec);
+		return OK;
+	}
+}
+
+Status IndexNestedLoopsIterator::Close() {
+	isOpen = false;
+	delete btScan;
+	btScan = NULL;
+
+	if (innerPage != NULL) {
+		innerPage = NULL;
+		UNPIN (innerPid, CLEAN);
+	}
+	innerPid = INVALID_PAGE;
+
+	if (bTree != NULL) {
+		bTree->DestroyFile();
+		delete bTree;
+		bTree = NULL;
 	}
+	delete filter;
+	filter = NULL;
 
-	out.file = tmpHeap;
-	delete leftScan;
-	delete [] leftRec;
-	bTree->DestroyFile();
-	delete bTree;
+	delete innerTmp;
+	innerTmp = NULL;
 
-	return OK;
-}
\ No newline at end of file
+	return outer->Close();
+}
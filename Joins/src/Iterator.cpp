@@ -0,0 +1,206 @@
+#include <string.h>
+
+#include "Iterator.h"
+#include "bufmgr.h"
+
+
+//--------------------------------------------------------------------
+// HeapFileIterator::HeapFileIterator
+//
+// Input   :  file   - The HeapFile to scan.
+//            recLen - The length of the records in the file (assume fixed size).
+//--------------------------------------------------------------------
+HeapFileIterator::HeapFileIterator(HeapFile* file, int recLen) {
+	this->file = file;
+	this->recLen = recLen;
+	scan = NULL;
+	numOfScans = 0;
+	numOfPages = 0;
+	zones = NULL;
+	zonesComplete = false;
+	keyLow = 0;
+	keyHigh = 0;
+}
+
+HeapFileIterator::~HeapFileIterator() {
+	Close();
+	delete zones;
+}
+
+//--------------------------------------------------------------------
+// HeapFileIterator::SetKeyRange
+//
+// Purpose :  Remembers the key range for the next scans. The first scan
+//            after the range is set reads every page and builds a zone
+//            map of the key; later scans skip the pages it rules out.
+//--------------------------------------------------------------------
+void HeapFileIterator::SetKeyRange(int offset, int low, int high) {
+	if (zones == NULL || zones->GetOffset() != offset) {
+		delete zones;
+		zones = new ZoneMap(offset);
+		zonesComplete = false;
+	}
+	keyLow = low;
+	keyHigh = high;
+}
+
+//--------------------------------------------------------------------
+// HeapFileIterator::ClearKeyRange
+//
+// Purpose :  Drops the key range and its zone map, so that the next
+//            scans read every page again.
+//--------------------------------------------------------------------
+void HeapFileIterator::ClearKeyRange() {
+	delete zones;
+	zones = NULL;
+	zonesComplete = false;
+}
+
+Status HeapFileIterator::Open() {
+	// Alternate the direction of the scans of a cyclic input. A file that 
+	// fits in the buffer pool stays there in either direction, and 
+	// reversing would only make the reuse distance of its pages longer.
+	// The scan that proved the file too large ran forward, so the next
+	// one runs backward.
+	bool backward = false;
+	if (hint == CYCLIC && numOfPages >= (int)MINIBASE_BM->GetNumOfBuffers()) {
+		backward = numOfScans % 2 == 0;
+		numOfScans++;
+	}
+
+	Status s;
+	scan = new HeapFileScan(file, s, backward);
+	if (s != OK) {
+		std::cerr << "Failed to open scan on HeapFile." << std::endl;
+		delete scan;
+		scan = NULL;
+		return FAIL;
+	}
+
+	if (zones != NULL) {
+		if (zonesComplete) {
+			scan->SetKeyRange(zones, keyLow, keyHigh);
+		}
+		else {
+			zones->Clear();
+			scan->BuildZoneMap(zones);
+		}
+	}
+	return OK;
+}
+
+Status HeapFileIterator::Next(char*& recPtr) {
+	RecordID rid;
+	int len;
+	Status s = scan->GetNext(rid, recPtr, len);
+	if (s == DONE) {
+		// The scan has seen every page
+		if (zones != NULL) zonesComplete = true;
+		return DONE;
+	}
+	if (s != OK) return FAIL;
+	return OK;
+}
+
+Status HeapFileIterator::Close() {
+	if (scan != NULL && scan->GetNumOfPagesRead() > numOfPages) {
+		numOfPages = scan->GetNumOfPagesRead();
+	}
+	delete scan;
+	scan = NULL;
+	return OK;
+}
+
+
+//--------------------------------------------------------------------
+// FilterIterator::FilterIterator
+//
+// Input   :  child  - The iterator producing the records to filter.
+//            offset - Offset of the integer attribute to test.
+//            op     - The comparison to apply (aopEQ ... aopGE).
+//            value  - The constant to compare the attribute with.
+//--------------------------------------------------------------------
+FilterIterator::FilterIterator(Iterator* child, int offset, AttrOperator op, int value) {
+	this->child = child;
+	this->offset = offset;
+	this->op = op;
+	this->value = value;
+	recLen = child->GetRecLen();
+}
+
+FilterIterator::~FilterIterator() {
+	delete child;
+}
+
+Status FilterIterator::Open() {
+	return child->Open();
+}
+
+Status FilterIterator::Next(char*& recPtr) {
+	while (true) {
+		Status s = child->Next(recPtr);
+		if (s != OK) return s;
+
+		int attr = *(int*)(recPtr + offset);
+		bool match;
+		switch (op) {
+		case aopEQ: match = attr == value; break;
+		case aopLT: match = attr <  value; break;
+		case aopGT: match = attr >  value; break;
+		case aopNE: match = attr != value; break;
+		case aopLE: match = attr <= value; break;
+		case aopGE: match = attr >= value; break;
+		default:
+			std::cerr << "Unsupported operator in FilterIterator." << std::endl;
+			return FAIL;
+		}
+		if (match) return OK;
+	}
+}
+
+Status FilterIterator::Close() {
+	return child->Close();
+}
+
+
+//--------------------------------------------------------------------
+// ProjectIterator::ProjectIterator
+//
+// Input   :  child     - The iterator producing the records to project.
+//            numOfAttr - The number of attributes in the output.
+//            attrs     - The child attributes to keep, in output order.
+//--------------------------------------------------------------------
+ProjectIterator::ProjectIterator(Iterator* child, int numOfAttr, const int* attrs) {
+	this->child = child;
+	this->numOfAttr = numOfAttr;
+	this->attrs = new int[numOfAttr];
+	memcpy(this->attrs, attrs, numOfAttr * sizeof(int));
+	recLen = numOfAttr * sizeof(int);
+	rec = new char[recLen];
+}
+
+ProjectIterator::~ProjectIterator() {
+	delete child;
+	delete [] attrs;
+	delete [] rec;
+}
+
+Status ProjectIterator::Open() {
+	return child->Open();
+}
+
+Status ProjectIterator::Next(char*& recPtr) {
+	char *childRec;
+	Status s = child->Next(childRec);
+	if (s != OK) return s;
+
+	for (int i = 0; i < numOfAttr; i++) {
+		((int*)rec)[i] = ((int*)childRec)[attrs[i]];
+	}
+	recPtr = rec;
+	return OK;
+}
+
+Status ProjectIterator::Close() {
+	return child->Close();
+}
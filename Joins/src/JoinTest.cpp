@@ -34,6 +34,22 @@ void JoinTest::RunTests(std::istream& in, int dbSize, int buffPoolSize) {
 			in >> testNum;
 			RunTest(testNum);
 		}
+		else if(!strcmp(command, "bench")) {
+			int empSize, projSize;
+			in >> empSize >> projSize;
+			RunBenchmark(empSize, projSize, RANDOM);
+		}
+		else if(!strcmp(command, "packedbench")) {
+			int empSize, projSize;
+			in >> empSize >> projSize;
+			RunBenchmark(empSize, projSize, RANDOM, PACKED_PAGES);
+		}
+		else if(!strcmp(command, "stats")) {
+			BufStats::Print(std::cout);
+			BufStats::Reset();
+			BloomFilter::PrintStat(std::cout);
+			BloomFilter::ResetStat();
+		}
 		else if(!strcmp(command, "quit")) {
 			break;
 		}
@@ -74,6 +90,15 @@ void JoinTest::RunTest(int i) {
 	case 4:
 		res = Test4();
 		break;
+	case 5:
+		res = Test5();
+		break;
+	case 6:
+		res = Test6();
+		break;
+	case 7:
+		res = Test7();
+		break;
 	default:
 		std::cerr << "Unknown test case!" << std::endl;
 		return;
@@ -87,6 +112,130 @@ void JoinTest::RunTest(int i) {
 	}
 }
 
+//--------------------------------------------------------------------
+// JoinTest::RunBenchmark
+// 
+// Purpose :  Runs every join method on the same pair of generated 
+//            relations and prints the buffer pool pins, misses, miss 
+//            rate and running time of each, and the share of the probes
+//            that passed its Bloom filters. 
+// Input   :  empSize    - The size of the first relation (Employee)
+//            projSize   - The size of the second relation (Project)
+//            opts       - Options. Whether the join should return no
+//                         results or be a complete cross product. 
+//            format     - The page format of both relations. 
+// Output  :  None
+// Return  :  None
+//-------------------------------------------------------------------- 
+void JoinTest::RunBenchmark(int empSize, int projSize, GenOpts opts,
+	                        PageFormat format) {
+	JoinSpec emp;
+	JoinSpec proj;
+
+	Status s;
+	s = TestSchema::CreateRandomEmployeeRelation(emp, empSize, projSize,
+		                                         false, opts, format);
+	if(s == FAIL) {
+		std::cerr << "Error creating employee relation." << std::endl;
+		return;
+	}
+
+	s = TestSchema::CreateRandomProjectRelation(proj, empSize, projSize,
+		                                        false, opts, format);
+	if(s == FAIL) {
+		std::cerr << "Error creating project relation." << std::endl;
+		emp.file->DeleteFile();
+		delete emp.file;
+		return;
+	}
+
+	TupleNestedLoops tl;
+	BlockNestedLoops bl;
+	IndexNestedLoops inl;
+	SortMerge sm;
+	BatchNestedLoops bat;
+	JoinMethod* methods[] = { &tl, &bl, &inl, &sm, &bat };
+	const char* names[] = { "TupleNestedLoops", "BlockNestedLoops", 
+		                    "IndexNestedLoops", "SortMerge", "BatchNestedLoops" };
+
+	std::cout << "Benchmark: " << empSize << " employees, " << projSize 
+		      << " projects, " << MINIBASE_BM->GetNumOfBuffers() << " buffers" 
+			  << std::endl;
+
+	for(int i = 0; i < 5; i++) {
+		// Start every join from an empty pool, so that no join gets the
+		// pages an earlier one left behind
+		if(EmptyBufferPool() != OK) {
+			std::cerr << "Cannot empty the buffer pool, misses depend on the order"
+				      << " of the joins." << std::endl;
+		}
+		MINIBASE_BM->ResetStat();
+		BloomFilter::ResetStat();
+		clock_t start = clock();
+
+		JoinSpec out;
+		s = methods[i]->Execute(emp, proj, out);
+
+		clock_t end = clock();
+		long pins, misses;
+		MINIBASE_BM->GetStat(pins, misses);
+		long probes, passes;
+		BloomFilter::GetStat(probes, passes);
+
+		if(s == FAIL) {
+			std::cout << names[i] << ": FAILED" << std::endl;
+			continue;
+		}
+
+		std::cout << names[i] << ": " << out.GetNumOfRecords() << " results, " 
+			      << pins << " pins, " << misses << " misses (" 
+				  << (pins > 0 ? 100.0 * misses / pins : 0.0) << "%), "
+				  << 1000 * (end - start) / CLOCKS_PER_SEC << " ms";
+		if(probes > 0) {
+			std::cout << ", " << (100.0 * passes / probes) << "% of " << probes 
+				      << " Bloom filter probes passed";
+		}
+		std::cout << std::endl;
+		delete out.file;
+	}
+
+	emp.file->DeleteFile();
+	proj.file->DeleteFile();
+	delete emp.file;
+	delete proj.file;
+}
+
+
+//--------------------------------------------------------------------
+// JoinTest::EmptyBufferPool
+// 
+// Purpose :  Writes the dirty pages back and displaces every page in the 
+//            buffer pool, by pinning and unpinning as many scratch pages 
+//            as there are frames, which are then freed. 
+// Return  :  OK, or FAIL if the scratch pages could not be allocated. 
+//-------------------------------------------------------------------- 
+Status JoinTest::EmptyBufferPool() {
+	if(MINIBASE_BM->FlushAllPages() != OK) return FAIL;
+
+	int n = MINIBASE_BM->GetNumOfBuffers();
+	PageID first;
+	Page *page;
+	if(MINIBASE_BM->NewPage(first, page, n) != OK) return FAIL;
+	MINIBASE_BM->UnpinPage(first, CLEAN);
+
+	// NewPage only pinned the first page, the others take a frame each
+	for(int i = 1; i < n; i++) {
+		if(MINIBASE_BM->PinPage(first + i, page, true) == OK) {
+			MINIBASE_BM->UnpinPage(first + i, CLEAN);
+		}
+	}
+	for(int i = 0; i < n; i++) {
+		MINIBASE_BM->FreePage(first + i);
+	}
+	return OK;
+}
+
+
 //--------------------------------------------------------------------
 // JoinMethod::TestValid
 // 
@@ -102,12 +251,15 @@ void JoinTest::RunTest(int i) {
 // Return  :  True iff the test passed. 
 //-------------------------------------------------------------------- 
 bool JoinTest::TestValid(JoinSpec& l, JoinSpec &r, JoinSpec &out, int count) {
+	BufStatsScope scope("TestValid");
 	Status s;
 
-	Scan* scan = out.file->OpenScan(s);
+	// One pass over the output, read it through a ring if it's large
+	HeapFileScan* scan = new HeapFileScan(out.file, s, false, 
+		                                  HeapFileScan::ExceedsPool(out.file));
 
 	RecordID rid;
-	char* rec = new char[out.recLen];
+	char* rec;
 	int recLen = out.recLen;
 	bool ret = true;
 
@@ -133,6 +285,7 @@ bool JoinTest::TestValid(JoinSpec& l, JoinSpec &r, JoinSpec &out, int count) {
 		ret = false;
 	}
 
+	delete scan;
 	return ret;
 }
 
@@ -190,7 +343,7 @@ bool JoinTest::CompareJoins(JoinMethod& j1, JoinMethod& j2,
 		return false;
 	}
 
-	if(out1.file->GetNumOfRecords() != out2.file->GetNumOfRecords()) {
+	if(out1.GetNumOfRecords() != out2.GetNumOfRecords()) {
 		std::cerr << "Error: Join results have different number of records." 
 			      << std::endl;
 		return false;
@@ -204,34 +357,44 @@ bool JoinTest::CompareJoins(JoinMethod& j1, JoinMethod& j2,
 	HeapFile* sorted1 = JoinMethod::SortHeapFile(out1.file, out1.recLen, leftSpec.numOfAttr * sizeof(int));
 	HeapFile* sorted2 = JoinMethod::SortHeapFile(out2.file, out2.recLen, leftSpec.numOfAttr * sizeof(int));
 
-	HeapFile* sorted1final = JoinMethod::SortHeapFile(sorted1, out1.recLen, 0);
-	HeapFile* sorted2final = JoinMethod::SortHeapFile(sorted2, out2.recLen, 0);
+	HeapFile* sorted1final = sorted1 == NULL ? NULL : JoinMethod::SortHeapFile(sorted1, out1.recLen, 0);
+	HeapFile* sorted2final = sorted2 == NULL ? NULL : JoinMethod::SortHeapFile(sorted2, out2.recLen, 0);
 
 	delete sorted1;
 	delete sorted2;
 
+	if(sorted1final == NULL || sorted2final == NULL) {
+		std::cerr << "Error: Cannot sort join results." << std::endl;
+		delete sorted1final;
+		delete sorted2final;
+		return false;
+	}
+
 	// Compare the sorted relations.
 
-	Scan* scan1 = sorted1final->OpenScan(s);
+	HeapFileScan* scan1 = new HeapFileScan(sorted1final, s);
 	if(s != OK) {
 		std::cerr << "Error opening scan1 in CompareJoins." << std::endl;
 	}
 
-	Scan* scan2 = sorted2final->OpenScan(s);
+	HeapFileScan* scan2 = new HeapFileScan(sorted2final, s);
 	if(s != OK) {
 		std::cerr << "Error opening scan2 in CompareJoins." << std::endl;
 	}
-	char* rec1 = new char[out1.recLen];
-	char* rec2 = new char[out2.recLen];
+	char* rec1;
+	char* rec2;
+	int len1, len2;
 	RecordID rid1, rid2;
 
 	bool ans = true;
 	// Loop through relation R, one tuple at a time
-	while(scan1->GetNext(rid1, rec1, out1.recLen) == OK) {
+	while(scan1->GetNext(rid1, rec1, len1) == OK) {
 
-		if(scan2->GetNext(rid2, rec2, out2.recLen) != OK) {
+		if(scan2->GetNext(rid2, rec2, len2) != OK) {
 			std::cerr << "Error fetching record from scan2 in CompareJoins." 
 				      << std::endl;
+			ans = false;
+			break;
 		}
 
 		int* intRec1 = (int*)rec1;
@@ -260,12 +423,12 @@ bool JoinTest::CompareJoins(JoinMethod& j1, JoinMethod& j2,
 
 	}
 
+	delete scan1;
+	delete scan2;
 	delete out1.file;
 	delete out2.file;
 	delete sorted1final;
 	delete sorted2final;
-	delete [] rec1;
-	delete [] rec2;
 
 	return ans;
 }
@@ -282,6 +445,8 @@ bool JoinTest::CompareJoins(JoinMethod& j1, JoinMethod& j2,
 //            foreignKey - Whether the join should be a foreign key join. 
 //            opts       - Options. Whether the join should return no
 //                         results or be a complete cross product. 
+//            empFormat  - The page format of the Employee relation. 
+//            projFormat - The page format of the Project relation. 
 // Output  :  None
 // Return  :  True iff the test passed. 
 // Note    :  opts cannot be ALL_MATCH if foreignKey is true. 
@@ -291,14 +456,16 @@ bool JoinTest::GenAndCompareJoins(JoinMethod* j1,
 								  int empSize,
 								  int projSize,
 								  bool foreignKey,
-								  GenOpts opts) {
+								  GenOpts opts,
+								  PageFormat empFormat,
+								  PageFormat projFormat) {
 
 	JoinSpec emp;
 	JoinSpec proj;
 
 	Status s;
 	s = TestSchema::CreateRandomEmployeeRelation(emp, empSize, projSize,
-		                                         foreignKey, opts);
+		                                         foreignKey, opts, empFormat);
 
 	if(s == FAIL) {
 		std::cerr << "Error creating employee relation." << std::endl;
@@ -306,7 +473,7 @@ bool JoinTest::GenAndCompareJoins(JoinMethod* j1,
 	}
 
 	s = TestSchema::CreateRandomProjectRelation(proj, empSize, projSize,
-		                                        foreignKey, opts);
+		                                        foreignKey, opts, projFormat);
 
 	if(s == FAIL) {
 		std::cerr << "Error creating project relation." << std::endl;
@@ -386,6 +553,30 @@ bool JoinTest::GenAndTestCount(JoinMethod* j1,
 
 
 
+//--------------------------------------------------------------------
+// JoinTest::CountIterator
+// 
+// Purpose :  Drains an iterator and counts its output. 
+// Input   :  it - The iterator to drain. 
+// Output  :  None
+// Return  :  The number of records produced, or -1 on error. 
+//-------------------------------------------------------------------- 
+int JoinTest::CountIterator(Iterator* it) {
+	if(it->Open() != OK) {
+		return -1;
+	}
+
+	int num = 0;
+	char* rec;
+	Status s;
+	while((s = it->Next(rec)) == OK) {
+		num++;
+	}
+	it->Close();
+
+	return (s == DONE) ? num : -1;
+}
+
 
 
 
@@ -476,6 +667,14 @@ bool JoinTest::Test3() {
 	ret = ret && GenAndCompareJoins(&tl, &inl, 1000, 1000, false, NONE_MATCH);
 	ret = ret && GenAndCompareJoins(&tl, &inl, 100, 100, false, ALL_MATCH);
 
+	// Inputs on column-wise pages. 
+	ret = ret && GenAndCompareJoins(&tl, &inl, 1000, 1000, false, RANDOM, 
+		                            PAX_PAGES, SLOTTED_PAGES);
+	ret = ret && GenAndCompareJoins(&tl, &inl, 1000, 1000, true, RANDOM, 
+		                            SLOTTED_PAGES, PAX_PAGES);
+	ret = ret && GenAndCompareJoins(&tl, &inl, 1000, 1000, false, RANDOM, 
+		                            PACKED_PAGES, PACKED_PAGES);
+
 	//MINIBASE_DB->dump_space_map();
 	return ret;
 }
@@ -499,6 +698,238 @@ bool JoinTest::Test4() {
 	ret = ret && GenAndCompareJoins(&tl, &sm, 1000, 1000, false, NONE_MATCH);
 	ret = ret && GenAndCompareJoins(&tl, &sm, 100, 100, false, ALL_MATCH);
 
+	// Inputs on column-wise pages. 
+	ret = ret && GenAndCompareJoins(&tl, &sm, 1000, 1000, false, RANDOM, 
+		                            PAX_PAGES, SLOTTED_PAGES);
+	ret = ret && GenAndCompareJoins(&tl, &sm, 1000, 1000, true, RANDOM, 
+		                            SLOTTED_PAGES, PAX_PAGES);
+	ret = ret && GenAndCompareJoins(&tl, &sm, 1000, 1000, false, RANDOM, 
+		                            PACKED_PAGES, PACKED_PAGES);
+
+	// Sorting a relation larger than the buffer pool reads it through a
+	// ring, outside the pool. 
+	JoinSpec emp;
+	JoinSpec proj;
+	Status s;
+	s = TestSchema::CreateRandomEmployeeRelation(emp, 10000, 100, false, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating employee relation." << std::endl;
+		return false;
+	}
+
+	s = TestSchema::CreateRandomProjectRelation(proj, 10000, 100, false, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating project relation." << std::endl;
+		emp.file->DeleteFile();
+		delete emp.file;
+		return false;
+	}
+
+	if(ret && !HeapFileScan::ExceedsPool(emp.file)) {
+		std::cerr << "Error: The employee relation fits in the buffer pool." 
+			      << std::endl;
+		ret = false;
+	}
+
+	BufStats::Reset();
+	ret = ret && CompareJoins(tl, sm, emp, proj);
+
+	long pins = 0, misses = 0, reads = 0;
+	if(ret && (!BufStats::Get("Sort", pins, misses, reads) || 
+		       reads < HeapFileScan::CountPages(emp.file))) {
+		std::cerr << "Error: Expected the " << HeapFileScan::CountPages(emp.file)
+			      << " employee pages to be read through a ring, but only " 
+				  << reads << " pages were." << std::endl;
+		ret = false;
+	}
+
+	emp.file->DeleteFile();
+	proj.file->DeleteFile();
+	delete emp.file;
+	delete proj.file;
+
+	return ret;
+}
+
+
+//--------------------------------------------------------------------
+// Tests the pipelined iterators of all join methods. Each join is 
+// drained directly, and then fed into a second join without being 
+// materialized. 
+//--------------------------------------------------------------------
+bool JoinTest::Test5() {
+	TupleNestedLoops tl;
+	BlockNestedLoops bl(50);
+	IndexNestedLoops inl;
+	SortMerge sm;
+	BatchNestedLoops bat;
+	JoinMethod* methods[] = { &tl, &bl, &inl, &sm, &bat };
+
+	JoinSpec emp;
+	JoinSpec proj;
+
+	Status s;
+	s = TestSchema::CreateRandomEmployeeRelation(emp, 1000, 100, true, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating employee relation." << std::endl;
+		return false;
+	}
+
+	s = TestSchema::CreateRandomProjectRelation(proj, 1000, 100, true, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating project relation." << std::endl;
+		return false;
+	}
+
+	bool ret = true;
+	for(int i = 0; i < 5 && ret; i++) {
+		// Every employee works on exactly one project. 
+		Iterator* it = methods[i]->CreateIterator(emp, proj);
+		int count = CountIterator(it);
+		delete it;
+		if(count != 1000) {
+			std::cerr << "Error: Expected 1000 results, but got " << count 
+				      << std::endl;
+			ret = false;
+			break;
+		}
+
+		// Join the output with proj again, on the project of the employee. 
+		JoinSpec empProj;
+		methods[i]->JoinMethod::Execute(emp, proj, empProj);
+		empProj.joinAttr = emp.joinAttr;
+		empProj.offset = emp.offset;
+
+		JoinSpec out;
+		methods[i]->JoinMethod::Execute(empProj, proj, out);
+		it = methods[i]->Pipeline(methods[i]->CreateIterator(emp, proj), 
+			                      new HeapFileIterator(proj.file, proj.recLen),
+								  empProj, proj);
+		s = JoinMethod::Materialize(it, out);
+		delete it;
+		if(s == FAIL) {
+			ret = false;
+			break;
+		}
+
+		ret = TestValid(empProj, proj, out, 1000);
+		delete out.file;
+	}
+
+	emp.file->DeleteFile();
+	proj.file->DeleteFile();
+	delete emp.file;
+	delete proj.file;
+
+	return ret;
+}
+
+
+//--------------------------------------------------------------------
+// Tests BatchNestedLoops join by comparing with TupleNestedLoopsJoin, 
+// and the batch filter by comparing with FilterIterator. 
+//--------------------------------------------------------------------
+bool JoinTest::Test6() {
+	TupleNestedLoops tl;
+	BatchNestedLoops* bl = new BatchNestedLoops();
+
+	bool ret = GenAndCompareJoins(&tl, bl, 100, 100, true, RANDOM);
+	ret = ret && GenAndCompareJoins(&tl, bl, 100, 100, false, RANDOM);
+
+	ret = ret && GenAndCompareJoins(&tl, bl, 1000, 1000, true, RANDOM);
+	ret = ret && GenAndCompareJoins(&tl, bl, 1000, 1000, false, RANDOM);
+	ret = ret && GenAndCompareJoins(&tl, bl, 3000, 1000, false, RANDOM);
+
+	ret = ret && GenAndCompareJoins(&tl, bl, 1000, 1000, true, NONE_MATCH);
+	ret = ret && GenAndCompareJoins(&tl, bl, 1000, 1000, false, NONE_MATCH);
+	ret = ret && GenAndCompareJoins(&tl, bl, 100, 100, false, ALL_MATCH);
+
+	delete bl;
+	// A block size that splits input batches. 
+	bl = new BatchNestedLoops(300);
+	ret = ret && GenAndCompareJoins(&tl, bl, 1000, 3000, false, RANDOM);
+	ret = ret && GenAndCompareJoins(&tl, bl, 100, 100, false, ALL_MATCH);
+	delete bl;
+
+	JoinSpec emp;
+	JoinSpec proj;
+	Status s;
+	s = TestSchema::CreateRandomEmployeeRelation(emp, 3000, 1000, false, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating employee relation." << std::endl;
+		return false;
+	}
+
+	// Employees younger than 30. 
+	Iterator* it = new FilterIterator(new HeapFileIterator(emp.file, emp.recLen), 
+		                              sizeof(int), aopLT, 30);
+	int count = CountIterator(it);
+	delete it;
+
+	it = new BatchToRowIterator(new FilterBatchIterator(
+		     new ScanBatchIterator(new HeapFileIterator(emp.file, emp.recLen)), 
+			 1, aopLT, 30));
+	int batchCount = CountIterator(it);
+	delete it;
+
+	if(count <= 0 || count != batchCount) {
+		std::cerr << "Error: FilterIterator returned " << count 
+			      << " results, but FilterBatchIterator returned " << batchCount 
+				  << std::endl;
+		ret = false;
+	}
+
+	emp.file->DeleteFile();
+	delete emp.file;
+
+	return ret;
+}
+
+
+//--------------------------------------------------------------------
+// Tests BlockNestedLoops and BatchNestedLoops by comparing with 
+// TupleNestedLoopsJoin, on an inner relation larger than the buffer pool.
+// Small blocks make both joins rescan it several times, so the rescans 
+// alternate between backward and forward scans. 
+//--------------------------------------------------------------------
+bool JoinTest::Test7() {
+	TupleNestedLoops tl;
+	BlockNestedLoops bl(20);
+	BatchNestedLoops bat(20);
+
+	JoinSpec emp;
+	JoinSpec proj;
+
+	Status s;
+	s = TestSchema::CreateRandomEmployeeRelation(emp, 10000, 100, false, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating employee relation." << std::endl;
+		return false;
+	}
+
+	s = TestSchema::CreateRandomProjectRelation(proj, 10000, 100, false, RANDOM);
+	if(s == FAIL) {
+		std::cerr << "Error creating project relation." << std::endl;
+		emp.file->DeleteFile();
+		delete emp.file;
+		return false;
+	}
+
+	bool ret = true;
+	if(!HeapFileScan::ExceedsPool(emp.file)) {
+		std::cerr << "Error: The employee relation fits in the buffer pool." 
+			      << std::endl;
+		ret = false;
+	}
+
+	// The projects, the smaller relation, are the outer relation. 
+	ret = ret && CompareJoins(tl, bl, emp, proj);
+	ret = ret && CompareJoins(tl, bat, emp, proj);
+
+	emp.file->DeleteFile();
+	proj.file->DeleteFile();
+	delete emp.file;
+	delete proj.file;
 
 	return ret;
 }
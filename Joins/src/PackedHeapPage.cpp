@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "PackedHeapPage.h"
+
+
+//--------------------------------------------------------------------
+// PackedHeapPage::Width
+//
+// Input   :  min, max - The smallest and largest value of an attribute.
+// Return  :  The # of bits needed to store max - min.
+//--------------------------------------------------------------------
+int PackedHeapPage::Width(int min, int max) {
+	unsigned int range = (unsigned int)max - (unsigned int)min;
+	int width = 0;
+	while (range != 0) {
+		width++;
+		range >>= 1;
+	}
+	return width;
+}
+
+//--------------------------------------------------------------------
+// PackedHeapPage::Size
+//
+// Input   :  numOfAttr - The # of attributes of the records.
+//            numOfRecs - The # of records.
+//            widths    - The width of each attribute.
+// Return  :  The # of bytes of the data area needed to pack them.
+//--------------------------------------------------------------------
+int PackedHeapPage::Size(int numOfAttr, int numOfRecs, const int* widths) {
+	int words = 0;
+	for (int a = 0; a < numOfAttr; a++) {
+		if (widths[a] > 0) {
+			words += (numOfRecs * widths[a] + 31) / 32 + 1;
+		}
+	}
+	return numOfAttr * sizeof(PackedAttr) + words * sizeof(unsigned int);
+}
+
+//--------------------------------------------------------------------
+// PackedHeapPage::Pack
+//
+// Purpose :  Initializes the page and packs the records onto it. The
+//            records must fit, i.e. Size must not exceed
+//            HEAPPAGE_DATA_SIZE and numOfRecs must not exceed MaxRecords.
+// Input   :  pageNo    - The PageID of this page.
+//            rows      - The records, numOfAttr integers each.
+//            numOfRecs - The # of records.
+//            numOfAttr - The # of attributes of the records.
+//            mins      - The smallest value of each attribute.
+//            widths    - The width of each attribute.
+//--------------------------------------------------------------------
+void PackedHeapPage::Pack(PageID pageNo, const int* rows, int numOfRecs, int numOfAttr,
+	                      const int* mins, const int* widths) {
+	HeapPage::Init(pageNo);
+	type = PACKED_PAGE_TYPE;
+	freePtr = numOfAttr;
+	numOfSlots = numOfRecs;
+
+	int size = Size(numOfAttr, numOfRecs, widths);
+	memset(data, 0, size);
+
+	PackedAttr *attrs = Attrs();
+	unsigned int *words = Words();
+	int offset = numOfAttr * sizeof(PackedAttr) / sizeof(unsigned int);
+	for (int a = 0; a < numOfAttr; a++) {
+		int width = widths[a];
+		attrs[a].base = mins[a];
+		attrs[a].width = (short)width;
+		attrs[a].offset = (short)offset;
+		if (width == 0) continue;
+
+		unsigned int *col = words + offset;
+		const int *attr = rows + a;
+		for (int i = 0, pos = 0; i < numOfRecs; i++, pos += width, attr += numOfAttr) {
+			unsigned int value = (unsigned int)*attr - (unsigned int)mins[a];
+			int shift = pos & 31;
+			col[pos >> 5] |= value << shift;
+			if (shift + width > 32) {
+				col[(pos >> 5) + 1] |= value >> (32 - shift);
+			}
+		}
+		offset += (numOfRecs * width + 31) / 32 + 1;
+	}
+}
+
+//--------------------------------------------------------------------
+// PackedHeapPage::Unpack
+//
+// Purpose :  Decodes a whole column. Each value is read from a 64-bit
+//            window over the two words holding it, so the loop has no
+//            branches and the compiler can unroll or vectorize it.
+// Input   :  attr - The attribute to decode.
+// Output  :  out  - Attribute attr of each record, in slot order.
+//--------------------------------------------------------------------
+void PackedHeapPage::Unpack(int attr, int* out) {
+	PackedAttr &info = Attrs()[attr];
+	int n = numOfSlots;
+	int width = info.width;
+	unsigned int base = (unsigned int)info.base;
+
+	if (width == 0) {
+		for (int i = 0; i < n; i++) {
+			out[i] = (int)base;
+		}
+		return;
+	}
+
+	const unsigned int *col = Words() + info.offset;
+	unsigned long long mask = (1ULL << width) - 1;
+	for (int i = 0, pos = 0; i < n; i++, pos += width) {
+		unsigned long long window = col[pos >> 5] | ((unsigned long long)col[(pos >> 5) + 1] << 32);
+		out[i] = (int)((unsigned int)((window >> (pos & 31)) & mask) + base);
+	}
+}
+
+//--------------------------------------------------------------------
+// PackedHeapPage::Value
+//
+// Return  :  Attribute attr of record slotNo, decoded.
+//--------------------------------------------------------------------
+unsigned int PackedHeapPage::Value(int attr, int slotNo) {
+	PackedAttr &info = Attrs()[attr];
+	unsigned int base = (unsigned int)info.base;
+	if (info.width == 0) return base;
+
+	const unsigned int *col = Words() + info.offset;
+	int pos = slotNo * info.width;
+	unsigned long long window = col[pos >> 5] | ((unsigned long long)col[(pos >> 5) + 1] << 32);
+	unsigned long long mask = (1ULL << info.width) - 1;
+	return (unsigned int)((window >> (pos & 31)) & mask) + base;
+}
+
+//--------------------------------------------------------------------
+// PackedHeapPage::GetRecord
+//
+// Purpose :  Decodes the attributes of record rid.
+//--------------------------------------------------------------------
+Status PackedHeapPage::GetRecord(RecordID rid, char* recPtr, int& len) {
+	if (rid.slotNo < 0 || rid.slotNo >= numOfSlots) return FAIL;
+
+	int *attrs = (int *)recPtr;
+	for (int a = 0; a < freePtr; a++) {
+		attrs[a] = (int)Value(a, rid.slotNo);
+	}
+	len = GetRecLen();
+	return OK;
+}
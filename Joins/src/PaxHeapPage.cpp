@@ -0,0 +1,70 @@
+#include "PaxHeapPage.h"
+
+
+//--------------------------------------------------------------------
+// PaxHeapPage::Capacity
+//
+// Input   :  recLen - The length of the records.
+// Return  :  The # of records that fit on a page. Never more than a
+//            HeapPage can hold, so that readers can size their buffers
+//            for HeapPage.
+//--------------------------------------------------------------------
+int PaxHeapPage::Capacity(int recLen) {
+	int n = HEAPPAGE_DATA_SIZE / recLen;
+	int maxSlots = HEAPPAGE_DATA_SIZE / (2 * (int)sizeof(short));
+	return n < maxSlots ? n : maxSlots;
+}
+
+//--------------------------------------------------------------------
+// PaxHeapPage::Init
+//
+// Input   :  pageNo - The PageID of this page.
+//            recLen - The length of the records the page will hold.
+//--------------------------------------------------------------------
+void PaxHeapPage::Init(PageID pageNo, int recLen) {
+	HeapPage::Init(pageNo);
+	type = PAX_PAGE_TYPE;
+	freePtr = recLen / sizeof(int);
+	freeSpace = Capacity(recLen);
+	numOfSlots = 0;
+}
+
+//--------------------------------------------------------------------
+// PaxHeapPage::InsertRecord
+//
+// Purpose :  Scatters the attributes of a record into the minipages.
+// Input   :  recPtr - The record to insert.
+//            recLen - Its length, which must be the page's record length.
+// Output  :  rid    - The RecordID of the new record.
+// Return  :  OK, or DONE if the page is full, FAIL if recLen is wrong.
+//--------------------------------------------------------------------
+Status PaxHeapPage::InsertRecord(const char* recPtr, int recLen, RecordID& rid) {
+	if (recLen != GetRecLen()) return FAIL;
+	if (numOfSlots == freeSpace) return DONE;
+
+	int pos = numOfSlots++;
+	const int *attrs = (const int *)recPtr;
+	for (int a = 0; a < freePtr; a++) {
+		Column(a)[pos] = attrs[a];
+	}
+
+	rid.pageNo = pid;
+	rid.slotNo = pos;
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// PaxHeapPage::GetRecord
+//
+// Purpose :  Gathers the attributes of record rid from the minipages.
+//--------------------------------------------------------------------
+Status PaxHeapPage::GetRecord(RecordID rid, char* recPtr, int& len) {
+	if (rid.slotNo < 0 || rid.slotNo >= numOfSlots) return FAIL;
+
+	int *attrs = (int *)recPtr;
+	for (int a = 0; a < freePtr; a++) {
+		attrs[a] = Column(a)[rid.slotNo];
+	}
+	len = GetRecLen();
+	return OK;
+}
@@ -1,154 +1,239 @@
+#include <limits.h>
+
 #include "join.h"
-#include "scan.h"
+#include "HeapFileScan.h"
 
 
 //---------------------------------------------------------------
 // SortMerge::Execute
 //
-// Input:   left  - The left relation to join. 
-//          right - The right relation to join. 
-// Output:  out   - The relation to hold the ouptut. 
-// Return:  OK if join completed succesfully. FAIL otherwise. 
-//          
-// Purpose: Performs an sort merge join on the specified relations. 
+// Input:   left  - The left relation to join.
+//          right - The right relation to join.
+// Output:  out   - The relation to hold the ouptut.
+// Return:  OK if join completed succesfully. FAIL otherwise.
+//
+// Purpose: Performs an sort merge join on the specified relations.
 // Please see the pseudocode on page 460 of your text for more info
 // on this algorithm. You may use JoinMethod::SortHeapFile to sort
-// the relations. 
+// the relations.
 //---------------------------------------------------------------
 Status SortMerge::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	BufStatsScope scope("SortMerge");
 	JoinMethod::Execute(left, right, out);
 
-	// Make sure left relation is smaller, if not need to swap JoinSpecs
-	bool swapped = false;
-	if (left.file->GetNumOfRecords() > right.file->GetNumOfRecords()) {
-		JoinSpec tmp = left;
-		left = right;
-		right = tmp;
+	Iterator *it = CreateIterator(left, right);
+	Status s = Materialize(it, out);
+	delete it;
+
+	return s;
+}
 
-		swapped = true;
+//---------------------------------------------------------------
+// SortMerge::Pipeline
+//
+// Input:   left      - The left input to join.
+//          right     - The right input to join.
+//          leftSpec  - Describes the records produced by left.
+//          rightSpec - Describes the records produced by right.
+// Return:  A pipelined iterator over the join. When both inputs are
+//          stored relations, the smaller one is used as the outer
+//          relation; otherwise left is the outer relation.
+//---------------------------------------------------------------
+Iterator* SortMerge::Pipeline(Iterator* left, Iterator* right,
+	                          JoinSpec& leftSpec, JoinSpec& rightSpec) {
+	// Make sure outer relation is smaller, if not need to swap inputs
+	if (leftSpec.file != NULL && rightSpec.file != NULL &&
+		leftSpec.GetNumOfRecords() > rightSpec.GetNumOfRecords()) {
+		return new SortMergeIterator(right, left, rightSpec, leftSpec, true);
 	}
+	return new SortMergeIterator(left, right, leftSpec, rightSpec, false);
+}
+
+
+SortMergeIterator::SortMergeIterator(Iterator* outer, Iterator* inner,
+	                                 JoinSpec& outerSpec, JoinSpec& innerSpec,
+									 bool swapped)
+	: JoinIterator(outer, inner, outerSpec, innerSpec, swapped) {
+	sortedOuter = NULL;
+	sortedInner = NULL;
+	outerScan = NULL;
+	innerScan = NULL;
+	outerZones = NULL;
+	innerZones = NULL;
+	outerMax = INT_MIN;
+	innerMax = INT_MIN;
+	outerRec = NULL;
+	innerRec = NULL;
+	outerStatus = DONE;
+	innerStatus = DONE;
+	inPartition = false;
+}
+
+SortMergeIterator::~SortMergeIterator() {
+	Close();
+}
+
+Status SortMergeIterator::AdvanceOuter() {
+	RecordID rid;
+	int len;
+	outerStatus = outerScan->GetNext(rid, outerRec, len);
+	return (outerStatus == OK || outerStatus == DONE) ? OK : FAIL;
+}
+
+Status SortMergeIterator::AdvanceInner() {
+	int len;
+	innerStatus = innerScan->GetNext(innerRid, innerRec, len);
+	return (innerStatus == OK || innerStatus == DONE) ? OK : FAIL;
+}
 
-	// Create the temporary heapfile
-	Status s;
-	HeapFile *tmpHeap = new HeapFile(NULL, s);
-	if (s != OK) {
-		std::cerr << "Failed to create output heapfile." << std::endl;
+//---------------------------------------------------------------
+// SortMergeIterator::Open
+//
+// Purpose: Sorts both inputs on their join attributes and positions
+//          a scan on the first record of each sorted relation.
+//---------------------------------------------------------------
+Status SortMergeIterator::Open() {
+	HeapFile *outerTmp, *innerTmp;
+	HeapFile *outerFile = InputFile(outer, outerSpec, outerTmp);
+	if (outerFile == NULL) return FAIL;
+	HeapFile *innerFile = InputFile(inner, innerSpec, innerTmp);
+	if (innerFile == NULL) {
+		delete outerTmp;
 		return FAIL;
 	}
 
-	// Need to sort relations
-	HeapFile *sortedLeft = JoinMethod::SortHeapFile(left.file, left.recLen, left.offset);
-	HeapFile *sortedRight = JoinMethod::SortHeapFile(right.file, right.recLen, right.offset);
+	// Need to sort relations. The keys of the outer relation, the smaller
+	// one, go into a Bloom filter, and the inner records it rules out,
+	// including all those outside the range of the outer keys, are
+	// dropped before they are sorted.
+	outerZones = new ZoneMap(outerSpec.offset);
+	innerZones = new ZoneMap(innerSpec.offset);
+	BloomFilter filter(outerSpec.GetNumOfRecords());
+	sortedOuter = JoinMethod::SortHeapFile(outerFile, outerSpec.recLen, outerSpec.offset, outerZones,
+		                                   &filter, NULL);
+	sortedInner = JoinMethod::SortHeapFile(innerFile, innerSpec.recLen, innerSpec.offset, innerZones,
+		                                   NULL, &filter);
+	delete outerTmp;
+	delete innerTmp;
+	if (sortedOuter == NULL || sortedInner == NULL) {
+		std::cerr << "Failed to sort the join inputs." << std::endl;
+		return FAIL;
+	}
 
-	// Open scan on sorted left relation
-	Status sortedLeftStatus;
-	Scan *sortedLeftScan = sortedLeft->OpenScan(sortedLeftStatus);
-	if (sortedLeftStatus != OK) {
-		std::cerr << "Failed to open scan on sorted left relation" << std::endl;
+	// Open scan on sorted outer relation
+	Status s;
+	outerScan = new HeapFileScan(sortedOuter, s);
+	if (s != OK) {
+		std::cerr << "Failed to open scan on sorted outer relation" << std::endl;
 		return FAIL;
 	}
 
-	// Open scan on sorted right relation
-	Status sortedRightStatus;
-	Scan *sortedRightScan = sortedRight->OpenScan(sortedRightStatus);
-	if (sortedRightStatus != OK) {
-		std::cerr << "Failed to open scan on sorted right relation." << std::endl;
+	// Open scan on sorted inner relation
+	innerScan = new HeapFileScan(sortedInner, s);
+	if (s != OK) {
+		std::cerr << "Failed to open scan on sorted inner relation." << std::endl;
 		return FAIL;
 	}
 
-	// Get first elements of each relation.
-	char *sortedLeftRec = new char [left.recLen];
-	RecordID sortedLeftRid;
-	sortedLeftStatus = sortedLeftScan->GetNext(sortedLeftRid, sortedLeftRec, left.recLen);
-	if (sortedLeftStatus == DONE) return FAIL; // Left relation was empty
-	if (sortedLeftStatus != OK) return FAIL;
-	int *tR = (int*)(sortedLeftRec + left.offset);
-
-	char *sortedRightRec = new char[right.recLen];
-	RecordID sortedRightRid;
-	sortedRightStatus = sortedRightScan->GetNext(sortedRightRid, sortedRightRec, right.recLen);
-	if (sortedRightStatus == DONE) return FAIL; // Right relation was empty
-	if (sortedRightStatus != OK) return FAIL;
-	int *tS = (int*)(sortedRightRec + right.offset);
-
-	// Pointer to start of each partition
-	RecordID partitionRid;
-	int *tG = new int();
-	*tG = *tS;
-
-	// Keep scanning as long as we still can
-	while (sortedLeftStatus == OK && sortedRightStatus == OK) {
-		// Continue to scan R
-		while (*tR < *tG) {
-			sortedLeftStatus = sortedLeftScan->GetNext(sortedLeftRid, sortedLeftRec, left.recLen);
-			if (sortedLeftStatus == DONE) break;
-			if (sortedLeftStatus != OK) return FAIL;
-			tR = (int*)(sortedLeftRec + left.offset);
-		}
-		// Continue to scan S
-		while (*tR > *tG) {
-			sortedRightStatus = sortedRightScan->GetNext(sortedRightRid, sortedRightRec, right.recLen);
-			if (sortedRightStatus == DONE) break;
-			if (sortedRightStatus != OK) return FAIL;
-			tG = (int*)(sortedRightRec + right.offset);
-		}
+	// Each side can skip the pages below the other side's smallest key,
+	// and the merge ends at the first key past the other side's largest.
+	// An empty side leaves the ranges empty, and nothing matches.
+	int outerMin = INT_MAX;
+	int innerMin = INT_MAX;
+	outerMax = INT_MIN;
+	innerMax = INT_MIN;
+	if (outerZones->GetRange(outerMin, outerMax) && innerZones->GetRange(innerMin, innerMax)) {
+		outerScan->SetKeyRange(outerZones, innerMin, INT_MAX);
+		innerScan->SetKeyRange(innerZones, outerMin, INT_MAX);
+	}
 
-		*tS = *tG;
-		partitionRid = sortedRightRid;
-		
-		while (*tR == *tG) {
-			// Reset partition iterator tS
-			*tS = *tG;
-			while (*tS == *tR) {
-				//	Create the record and insert into tmpHeap...
-				char *joinedRec = new char[out.recLen];
-				
-				// Need to check if JoinSpecs have been swapped
-					if (swapped) 
-						MakeNewRecord(joinedRec, sortedRightRec, sortedLeftRec, right, left);
-					else
-						MakeNewRecord(joinedRec, sortedLeftRec, sortedRightRec, left, right);
-
-				RecordID insertedRid;
-				Status tmpStatus = tmpHeap->InsertRecord(joinedRec, out.recLen, insertedRid);
-
-				if (tmpStatus != OK) {
-					std::cerr << "Failed to insert tuple into output heapfile." << std::endl;
-					return FAIL;
-				}
-				delete [] joinedRec;
+	// Get first elements of each relation.
+	inPartition = false;
+	if (AdvanceOuter() != OK) return FAIL;
+	if (AdvanceInner() != OK) return FAIL;
+	return OK;
+}
 
-				sortedRightStatus = sortedRightScan->GetNext(sortedRightRid, sortedRightRec, right.recLen);
-				if (sortedRightStatus == DONE) break; //{sortedRightStatus = OK; break;}
-				if (sortedRightStatus != OK) return FAIL;
-				tS = (int*)(sortedRightRec + right.offset);
+//---------------------------------------------------------------
+// SortMergeIterator::Next
+//
+// Purpose: Returns the next matching <outer, inner> pair. Once a
+//          partition of equal keys is found, every outer tuple with
+//          that key is joined with the whole partition, rewinding the
+//          inner scan to the start of the partition for each of them.
+//---------------------------------------------------------------
+Status SortMergeIterator::Next(char*& recPtr) {
+	while (true) {
+		if (inPartition) {
+			int *tS = (int*)(innerRec + innerSpec.offset);
+			if (innerStatus == OK && *tS == partitionKey) {
+				recPtr = Join(outerRec, innerRec);
+				if (AdvanceInner() != OK) return FAIL;
+				return OK;
 			}
 
-			// Setup next tuple from left relation
-			sortedLeftStatus = sortedLeftScan->GetNext(sortedLeftRid, sortedLeftRec, left.recLen);
-			if (sortedLeftStatus == DONE) break;
-			if (sortedLeftStatus != OK) return FAIL;
-			tR = (int*)(sortedLeftRec + left.offset);
+			// Setup next tuple from outer relation
+			if (AdvanceOuter() != OK) return FAIL;
+			if (outerStatus == DONE) return DONE;
 
-			// Setup pointer to last known partition for new tuple from left relation
-			*tS = *tG;
-			sortedRightScan->MoveTo(partitionRid);
-			sortedRightStatus = sortedRightScan->GetNext(sortedRightRid, sortedRightRec, right.recLen);
+			int *tR = (int*)(outerRec + outerSpec.offset);
+			if (*tR == partitionKey) {
+				// Rewind to the start of the partition for the new outer tuple
+				if (innerScan->MoveTo(partitionRid) != OK) {
+					std::cerr << "Failed to rewind the inner scan." << std::endl;
+					return FAIL;
+				}
+				if (AdvanceInner() != OK) return FAIL;
+				continue;
+			}
+			inPartition = false;
 		}
 
-		// Initialize search for next partition
-		*tG = *tS;
-		sortedRightScan->MoveTo(sortedRightRid);
-		if (sortedRightStatus != DONE) 
-			sortedRightStatus = sortedRightScan->GetNext(sortedRightRid, sortedRightRec, right.recLen);
-	}
-
-	out.file = tmpHeap;
-	delete sortedLeftScan;
-	delete [] sortedLeftRec;
+		// Keep scanning as long as we still can
+		if (outerStatus != OK || innerStatus != OK) return DONE;
 
-	delete sortedRightScan;
-	delete [] sortedRightRec;
+		// No key beyond the largest key of the other side can match
+		int *tR = (int*)(outerRec + outerSpec.offset);
+		int *tS = (int*)(innerRec + innerSpec.offset);
+		if (*tR > innerMax || *tS > outerMax) return DONE;
 
+		// The side that is behind can skip the pages whose keys are all
+		// smaller than the other side's key. Neither side goes back below
+		// it; a rewind only returns to the start of the current partition.
+		if (*tR < *tS) {
+			outerScan->SetKeyRange(outerZones, *tS, INT_MAX);
+			if (AdvanceOuter() != OK) return FAIL;
+		}
+		else if (*tR > *tS) {
+			innerScan->SetKeyRange(innerZones, *tR, INT_MAX);
+			if (AdvanceInner() != OK) return FAIL;
+		}
+		else {
+			inPartition = true;
+			partitionKey = *tS;
+			partitionRid = innerRid;
+		}
+	}
+}
+
+Status SortMergeIterator::Close() {
+	delete outerScan;
+	delete innerScan;
+	outerScan = NULL;
+	innerScan = NULL;
+
+	delete sortedOuter;
+	delete sortedInner;
+	sortedOuter = NULL;
+	sortedInner = NULL;
+
+	delete outerZones;
+	delete innerZones;
+	outerZones = NULL;
+	innerZones = NULL;
+
+	outerStatus = DONE;
+	innerStatus = DONE;
+	inPartition = false;
 	return OK;
-}
\ No newline at end of file
+}
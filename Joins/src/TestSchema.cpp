@@ -7,6 +7,7 @@
 #include "TestSchema.h"
 #include "BTreeFile.h"
 #include "BTreeFileScan.h"
+#include "HeapFileWriter.h"
 
 
 
@@ -41,7 +42,8 @@ Status TestSchema::CreateRandomEmployeeRelation(JoinSpec& spec,
 	                                            int numEmployeeRecs,
 	                                            int numProjectRecs,
 												bool foreignKey,
-												GenOpts opts) {
+												GenOpts opts,
+												PageFormat format) {
 
 													
     if(foreignKey && opts == ALL_MATCH) {
@@ -54,11 +56,20 @@ Status TestSchema::CreateRandomEmployeeRelation(JoinSpec& spec,
 	HeapFile *F = new HeapFile ("Employees", s); // new HeapFile storing records of R
 	if (s != OK) {
 		std::cerr << "Cannot create new HeapFile Employees" << std::endl;
+		delete F;
+		return FAIL;
+	}
+
+	// The file is new, append instead of searching it for free space.
+	HeapFileWriter writer(F, s, format);
+	if (s != OK) {
+		std::cerr << "Cannot open writer on HeapFile Employees" << std::endl;
+		F->DeleteFile();
+		delete F;
 		return FAIL;
 	}
 
 	Employee e;
-	RecordID rid;
 	short* permutation = new short[numEmployeeRecs];
 
 	RandomPermute(permutation, numEmployeeRecs); // generate a random array of integer
@@ -89,13 +100,24 @@ Status TestSchema::CreateRandomEmployeeRelation(JoinSpec& spec,
 		e.rating = TestSchema::rand() % 5;
 		e.dept  = TestSchema::rand() % 30;
 
-		s = F->InsertRecord((char *)&e, sizeof(Employee), rid); // insert records into heapfile
+		s = writer.Append((char *)&e, sizeof(Employee)); // insert records into heapfile
 		if (s != OK)
 		{
 			std::cerr << "Cannot insert record " << i << " into R\n";
+			writer.Close();
+			F->DeleteFile();
+			delete F;
+			delete [] permutation;
 			return FAIL;
 		}
 	}
+	if (writer.Close() != OK) {
+		std::cerr << "Cannot close writer on HeapFile Employees" << std::endl;
+		F->DeleteFile();
+		delete F;
+		delete [] permutation;
+		return FAIL;
+	}
 
 	strcpy(spec.relName, "Employees");
 	spec.numOfAttr = NUM_EMPLOYEE_ATTRS;
@@ -107,6 +129,8 @@ Status TestSchema::CreateRandomEmployeeRelation(JoinSpec& spec,
 
 	spec.recLen = sizeof(Employee);
 	spec.file = F;
+	spec.numOfRecords = writer.GetNumOfRecords();
+	spec.numOfPages = writer.GetNumOfPages();
 	spec.offset = spec.joinAttr*sizeof(int);
 
 	delete [] permutation;
@@ -120,16 +144,26 @@ Status TestSchema::CreateRandomProjectRelation(JoinSpec& spec,
 	                                           int numEmployeeRecs,
 	                                           int numProjectRecs,
 											   bool foreignKey,
-											   GenOpts opts) {
+											   GenOpts opts,
+											   PageFormat format) {
 	Status s;
 	HeapFile *F = new HeapFile ("Projects", s); // new HeapFile storing records of R
 	if (s != OK) {
 		std::cerr << "Cannot create new HeapFile Projects\n";
+		delete F;
+		return FAIL;
+	}
+
+	// The file is new, append instead of searching it for free space.
+	HeapFileWriter writer(F, s, format);
+	if (s != OK) {
+		std::cerr << "Cannot open writer on HeapFile Projects\n";
+		F->DeleteFile();
+		delete F;
 		return FAIL;
 	}
 
 	Project p;
-	RecordID rid;
 	short* permutation = new short[numProjectRecs];
 
 	RandomPermute (permutation, numProjectRecs); // generate a random array of integer
@@ -162,13 +196,24 @@ Status TestSchema::CreateRandomProjectRelation(JoinSpec& spec,
 
 
 
-		s = F->InsertRecord((char *)&p, sizeof(Project), rid); // insert records into heapfile
+		s = writer.Append((char *)&p, sizeof(Project)); // insert records into heapfile
 		if (s != OK)
 		{
 			std::cerr << "Cannot insert record " << i << " into Project heapfile\n";
+			writer.Close();
+			F->DeleteFile();
+			delete F;
+			delete [] permutation;
 			return FAIL;
 		}
 	}
+	if (writer.Close() != OK) {
+		std::cerr << "Cannot close writer on HeapFile Projects\n";
+		F->DeleteFile();
+		delete F;
+		delete [] permutation;
+		return FAIL;
+	}
 
 	strcpy(spec.relName, "Project");
 	spec.numOfAttr = NUM_PROJECT_ATTRS;
@@ -179,6 +224,8 @@ Status TestSchema::CreateRandomProjectRelation(JoinSpec& spec,
 
 	spec.recLen = sizeof(Project);
 	spec.file = F;
+	spec.numOfRecords = writer.GetNumOfRecords();
+	spec.numOfPages = writer.GetNumOfPages();
 	spec.offset = spec.joinAttr * sizeof(int);
 
 	delete [] permutation;
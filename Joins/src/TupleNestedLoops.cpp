@@ -4,85 +4,99 @@
 //---------------------------------------------------------------
 // TupleNestedLoop::Execute
 //
-// Input:   left  - The left relation to join. 
-//          right - The right relation to join. 
-// Output:  out   - The relation to hold the ouptut. 
-// Return:  OK if join completed succesfully. FAIL otherwise. 
-//          
+// Input:   left  - The left relation to join.
+//          right - The right relation to join.
+// Output:  out   - The relation to hold the ouptut.
+// Return:  OK if join completed succesfully. FAIL otherwise.
+//
 // Purpose: Performs a nested loop join on relations left and right
 //          a tuple a time. You can assume that left is the outer
-//          relation and right is the inner relation. 
+//          relation and right is the inner relation.
 //---------------------------------------------------------------
 Status TupleNestedLoops::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	BufStatsScope scope("TupleNestedLoops");
 	JoinMethod::Execute(left, right, out);
 
-	//	Create the temporary heapfile
-	Status st;
-	HeapFile *tmpHeap = new HeapFile(NULL, st);
-	if (st != OK) {
-		std::cerr << "Failed to create output heapfile." << std::endl;
-		return FAIL;
-	}
-		
-	//	Open scan on left relation
-	Status leftStatus;
-	Scan *leftScan = left.file->OpenScan(leftStatus);
-	if (leftStatus != OK) {
-		std::cerr << "Failed to open scan on left relation." << std::endl;
-		return FAIL;
-	}
+	Iterator *it = CreateIterator(left, right);
+	Status s = Materialize(it, out);
+	delete it;
 
-	//	Loop over the left relation
-	char *leftRec = new char[left.recLen];
-	while (true) {
-		RecordID leftRid;
-		leftStatus = leftScan->GetNext(leftRid, leftRec, left.recLen);
-		if (leftStatus == DONE) break;
-		if (leftStatus != OK) return FAIL;
+	return s;
+}
 
-		// The join attribute on left relation
-		int *leftJoinValPtr = (int*)(leftRec + left.offset);
+//---------------------------------------------------------------
+// TupleNestedLoops::Pipeline
+//
+// Input:   left      - The left input to join.
+//          right     - The right input to join.
+//          leftSpec  - Describes the records produced by left.
+//          rightSpec - Describes the records produced by right.
+// Return:  A pipelined iterator over the join, with left as the
+//          outer relation.
+//---------------------------------------------------------------
+Iterator* TupleNestedLoops::Pipeline(Iterator* left, Iterator* right,
+	                                 JoinSpec& leftSpec, JoinSpec& rightSpec) {
+	return new TupleNestedLoopsIterator(left, right, leftSpec, rightSpec, false);
+}
 
-		//	Open scan on right relation
-		Status rightStatus;
-		Scan *rightScan = right.file->OpenScan(rightStatus);
-		if (rightStatus != OK) {
-			std::cerr << "Failed to open scan on right relation." << std::endl;
-			return FAIL;
-		}
 
-		//	Loop over right relation
-		char *rightRec = new char[right.recLen];
-		while (true) {
-			RecordID rightRid;
-			rightStatus = rightScan->GetNext(rightRid, rightRec, right.recLen);
-			if (rightStatus == DONE) break;
-			if (rightStatus != OK) return FAIL;
+TupleNestedLoopsIterator::TupleNestedLoopsIterator(Iterator* outer, Iterator* inner,
+	                                               JoinSpec& outerSpec, JoinSpec& innerSpec,
+												   bool swapped)
+	: JoinIterator(outer, inner, outerSpec, innerSpec, swapped) {
+	outerRec = NULL;
+	inner->SetHint(CYCLIC);
+}
 
-			//	Compare join attribute
-			int *rightJoinValPtr = (int*)(rightRec + right.offset);
-			if (*leftJoinValPtr == *rightJoinValPtr) {
-				//	Create the record and insert into tmpHeap...
-				char *joinedRec = new char[out.recLen];
-				MakeNewRecord(joinedRec, leftRec, rightRec, left, right);
-				RecordID insertedRid;
-				Status tmpStatus = tmpHeap->InsertRecord(joinedRec, out.recLen, insertedRid);
+Status TupleNestedLoopsIterator::Open() {
+	outerRec = NULL;
+	return outer->Open();
+}
 
-				if (tmpStatus != OK) {
-					std::cerr << "Failed to insert tuple into output heapfile." << std::endl;
-					return FAIL;
-				}
-				delete [] joinedRec;
+//---------------------------------------------------------------
+// TupleNestedLoopsIterator::Next
+//
+// Purpose: Returns the next matching <outer, inner> pair. The inner
+//          input is reopened for every outer tuple.
+//---------------------------------------------------------------
+Status TupleNestedLoopsIterator::Next(char*& recPtr) {
+	while (true) {
+		// Move to the next outer tuple and restart the inner input
+		if (outerRec == NULL) {
+			Status outerStatus = outer->Next(outerRec);
+			if (outerStatus != OK) {
+				outerRec = NULL;
+				return outerStatus;
+			}
+			if (inner->Open() != OK) {
+				std::cerr << "Failed to open scan on inner relation." << std::endl;
+				return FAIL;
 			}
 		}
 
-		delete [] rightRec;
-		delete rightScan;
-	}
+		char *innerRec;
+		Status innerStatus = inner->Next(innerRec);
+		if (innerStatus == DONE) {
+			inner->Close();
+			outerRec = NULL;
+			continue;
+		}
+		if (innerStatus != OK) return FAIL;
 
-	out.file = tmpHeap;
-	delete leftScan;
-	delete [] leftRec;
+		//	Compare join attribute
+		int *outerJoinValPtr = (int*)(outerRec + outerSpec.offset);
+		int *innerJoinValPtr = (int*)(innerRec + innerSpec.offset);
+		if (*outerJoinValPtr == *innerJoinValPtr) {
+			recPtr = Join(outerRec, innerRec);
+			return OK;
+		}
+	}
+}
 
-	return OK;
-}
\ No newline at end of file
+Status TupleNestedLoopsIterator::Close() {
+	if (outerRec != NULL) {
+		inner->Close();
+		outerRec = NULL;
+	}
+	return outer->Close();
+}
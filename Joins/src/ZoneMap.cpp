@@ -0,0 +1,98 @@
+#include "ZoneMap.h"
+
+
+ZoneMap::ZoneMap(int offset) {
+	this->offset = offset;
+	size = ZONE_MAP_INITIAL_SIZE;
+	pids = new PageID[size];
+	mins = new int[size];
+	maxs = new int[size];
+	numOfPages = 0;
+}
+
+ZoneMap::~ZoneMap() {
+	delete [] pids;
+	delete [] mins;
+	delete [] maxs;
+}
+
+//--------------------------------------------------------------------
+// ZoneMap::Find
+//
+// Input   :  pid - A data page.
+// Return  :  The first entry whose PageID is not smaller than pid, or
+//            numOfPages if there is none.
+//--------------------------------------------------------------------
+int ZoneMap::Find(PageID pid) {
+	int lo = 0;
+	int hi = numOfPages;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (pids[mid] < pid) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+//--------------------------------------------------------------------
+// ZoneMap::Add
+//
+// Input   :  pid      - A data page of the file.
+//            min, max - The smallest and largest value of the attribute
+//                       on the page.
+//--------------------------------------------------------------------
+void ZoneMap::Add(PageID pid, int min, int max) {
+	// Pages are mostly added in ascending order, so check the end first
+	int i = (numOfPages == 0 || pids[numOfPages - 1] < pid) ? numOfPages : Find(pid);
+	if (i < numOfPages && pids[i] == pid) {
+		mins[i] = min;
+		maxs[i] = max;
+		return;
+	}
+
+	if (numOfPages == size) {
+		int newSize = size * 2;
+		PageID *newPids = new PageID[newSize];
+		int *newMins = new int[newSize];
+		int *newMaxs = new int[newSize];
+		for (int j = 0; j < numOfPages; j++) {
+			newPids[j] = pids[j];
+			newMins[j] = mins[j];
+			newMaxs[j] = maxs[j];
+		}
+		delete [] pids;
+		delete [] mins;
+		delete [] maxs;
+		pids = newPids;
+		mins = newMins;
+		maxs = newMaxs;
+		size = newSize;
+	}
+
+	for (int j = numOfPages; j > i; j--) {
+		pids[j] = pids[j - 1];
+		mins[j] = mins[j - 1];
+		maxs[j] = maxs[j - 1];
+	}
+	pids[i] = pid;
+	mins[i] = min;
+	maxs[i] = max;
+	numOfPages++;
+}
+
+bool ZoneMap::MayContain(PageID pid, int low, int high) {
+	int i = Find(pid);
+	if (i == numOfPages || pids[i] != pid) return true;
+	return mins[i] <= high && maxs[i] >= low;
+}
+
+bool ZoneMap::GetRange(int& min, int& max) {
+	if (numOfPages == 0) return false;
+	min = mins[0];
+	max = maxs[0];
+	for (int i = 1; i < numOfPages; i++) {
+		if (mins[i] < min) min = mins[i];
+		if (maxs[i] > max) max = maxs[i];
+	}
+	return true;
+}
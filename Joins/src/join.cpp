@@ -5,9 +5,12 @@
 #include "minirel.h"
 #include "heapfile.h"
 #include "scan.h"
+#include "bufmgr.h"
 #include "BTreeFile.h"
 #include "BTreeFileScan.h"
 #include "join.h"
+#include "HeapFileScan.h"
+#include "HeapFileWriter.h"
 
 
 //--------------------------------------------------------------------
@@ -21,10 +24,11 @@
 //-------------------------------------------------------------------- 
 void JoinSpec::PrintRelation(const char* filename) {
 	Status s;
-	Scan *scan = file->OpenScan(s);
+	HeapFileScan *scan = new HeapFileScan(file, s);
 
 	if (s != OK) {
 		std::cerr << "Cannot open scan on HeapFile in PrintRelation."<< std::endl;
+		delete scan;
 		return;
 	}
 
@@ -37,19 +41,20 @@ void JoinSpec::PrintRelation(const char* filename) {
 		f = fopen(filename, "w");
 		if (f == NULL) {
 			std::cerr << "Cannot open file " << filename << " for writing.\n";
+			delete scan;
 			return;
 		}
 	}
 
-	char* rec = new char[recLen];
+	char* rec;
 
 	int len = recLen;
 	RecordID rid;
 
-	while(scan->GetNext(rid, rec, len) != DONE) {
+	while(scan->GetNext(rid, rec, len) == OK) {
 		if(len != recLen) {
 			std::cerr << "Unexpected record length in print method." << std::endl;
-			return;
+			break;
 		}
 		for(int i = 0; i < numOfAttr; i++) {
 			fprintf(f, "%d ", *(((int*)(rec)) + i));
@@ -61,7 +66,33 @@ void JoinSpec::PrintRelation(const char* filename) {
 		fclose(f);
 	}
 
-	delete [] rec;
+	delete scan;
+}
+
+//--------------------------------------------------------------------
+// JoinSpec::GetNumOfRecords
+// 
+// Return  :  The # of records in file. Only the first call asks the 
+//            HeapFile, which walks its directory. 
+//-------------------------------------------------------------------- 
+int JoinSpec::GetNumOfRecords() {
+	if (numOfRecords < 0) {
+		numOfRecords = file->GetNumOfRecords();
+	}
+	return numOfRecords;
+}
+
+//--------------------------------------------------------------------
+// JoinSpec::GetNumOfPages
+// 
+// Return  :  The # of data pages in file. Only the first call walks 
+//            the directory. 
+//-------------------------------------------------------------------- 
+int JoinSpec::GetNumOfPages() {
+	if (numOfPages < 0) {
+		numOfPages = HeapFileScan::CountPages(file);
+	}
+	return numOfPages;
 }
 
 //-------------------------------------------------------------------
@@ -107,20 +138,35 @@ void JoinMethod::MakeNewRecord(char* newRec, char* leftRec, char* rightRec,
 // Input   :  file - pointer to the HeapFile to be sorted.
 //            len  - length of the records in the file. (assume fixed size).
 //            offset - offset of the sort attribute from the beginning of the record.
+//            zones  - if not NULL, filled with the range of the sort attribute
+//                     on each page of the sorted relation.
+//            build  - if not NULL, the sort attribute of every record is
+//                     added to it.
+//            probe  - if not NULL, the records whose sort attribute it
+//                     rules out are dropped.
 // Method  :  We create a B+-Tree using that attribute as the key. Then
 //            we scan the B+-Tree and insert the records into a new
 //            HeapFile. he HeapFile guarantees that the order of 
 //            insertion will be the same as the order of scan later.
-// Return  :  The new sorted relation/HeapFile.
+//            The sorted file is an internal temp file of FixedHeapPages
+//            and must be read with HeapFileScan.
+// Return  :  The new sorted relation/HeapFile, or NULL on error.
 //-------------------------------------------------------------------- 
-HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset) {
+HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset, ZoneMap *zones,
+	                               BloomFilter *build, BloomFilter *probe) {
+	BufStatsScope scope("Sort");
 
 	Status s;
 
-	Scan *scan;
-	scan = file->OpenScan(s);
+	// A large file is read through a ring so that it does not push the
+	// rest of the buffer pool out. A small one is left in the pool for the
+	// copy below.
+	HeapFileScan *scan;
+	scan = new HeapFileScan(file, s, false, HeapFileScan::ExceedsPool(file));
 	if (s != OK) {
 		std::cerr << "ERROR : cannot open scan on the heapfile to sort." << std::endl;
+		delete scan;
+		return NULL;
 	}
 
 	//
@@ -130,21 +176,34 @@ HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset) {
 	BTreeFile *btree;
 	btree = new BTreeFile (s, "BTree");
 
-	char* recPtr = new char[len];
+	char* recPtr;
 	int recLen = len;
 	RecordID rid;
 
 	char* recKey = new char[100];
 
-	while (scan->GetNext(rid, recPtr, recLen) == OK)
+	int* pageKeys;
+	RecordID* pageRids;
+	int numOfRecs;
+	bool ok = true;
+	Status scanStatus;
+	while ((scanStatus = scan->NextPageKeys(offset, pageKeys, pageRids, numOfRecs)) == OK)
 	{
-		int* valPtr = (int*)(recPtr+offset);
-		int val = *valPtr;
-		toString(val,recKey);
-		btree->Insert(recKey, rid);
+		for (int i = 0; i < numOfRecs; i++)
+		{
+			if (build != NULL) build->Add(pageKeys[i]);
+			if (probe != NULL && !probe->MayContain(pageKeys[i])) continue;
+			toString(pageKeys[i],recKey);
+			btree->Insert(recKey, pageRids[i]);
+		}
 	}
+	bool formatted = scan->HasFormattedPages();
 	delete scan;
 	delete [] recKey;
+	if (scanStatus != DONE) {
+		std::cerr << "ERROR : cannot read the heapfile to sort." << std::endl;
+		ok = false;
+	}
 	//std::cout << "created B+ tree!" << std::endl;
 
 	HeapFile *sorted = new HeapFile(NULL, s); // create a temp HeapFile
@@ -157,22 +216,65 @@ HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset) {
 	// new (sorted) HeapFile.
 
 	BTreeFileScan* btreeScan = btree->OpenScan(NULL, NULL);
+	HeapFileWriter writer(sorted, s, FIXED_PAGES);
+	writer.SetZoneMap(zones);
+	if (s != OK) {
+		std::cerr << "Cannot open writer on the sorted file." << std::endl;
+		ok = false;
+	}
 
 	//int key;
 	char* keyPtr;
-	while (btreeScan->GetNext(rid, keyPtr) == OK)
+	char* recBuf = new char[len];
+	PageID pid = INVALID_PAGE;
+	HeapPage *page = NULL;
+	while (ok && btreeScan->GetNext(rid, keyPtr) == OK)
 	{
 		//std::cout << "scanning " << rid << " " << keyPtr << std::endl;
 
-	    file->GetRecord (rid, recPtr, recLen);
-	    sorted->InsertRecord (recPtr, recLen, rid);
+		// Copy the record straight from its page into the sorted file. 
+		// Records with equal keys are often on the same page, so keep the
+		// last page pinned.
+		if (rid.pageNo != pid) {
+			if (page != NULL) {
+				MINIBASE_BM->UnpinPage(pid, CLEAN);
+				page = NULL;
+			}
+			pid = rid.pageNo;
+			if (MINIBASE_BM->PinPage(pid, (Page *&)page) != OK) {
+				std::cerr << "Unable to pin page " << pid << std::endl;
+				page = NULL;
+				ok = false;
+				break;
+			}
+		}
+		if (HeapFileScan::ReturnRecord (page, rid, recPtr, recLen, recBuf, formatted) != OK) {
+			std::cerr << "Record " << rid.pageNo << "." << rid.slotNo 
+				      << " is not part of the file to sort." << std::endl;
+			ok = false;
+		}
+		else if (writer.Append (recPtr, recLen) != OK) {
+			ok = false;
+		}
+	}
+	if (page != NULL) {
+		MINIBASE_BM->UnpinPage(pid, CLEAN);
+	}
+	delete [] recBuf;
+	if (writer.Close() != OK) {
+		ok = false;
 	}
 	btree->DestroyFile();
 
 	delete btree;
 	delete btreeScan;
-	delete [] recPtr;
 
+	if (!ok) {
+		// Don't hand out a partially sorted file. Deleting a temp file
+		// frees its pages.
+		delete sorted;
+		return NULL;
+	}
 	return sorted;
 }
 
@@ -182,11 +284,162 @@ HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset) {
 
 
 
+//--------------------------------------------------------------------
+// JoinMethod::Materialize
+// 
+// Purpose :  Drains an iterator into a new temporary HeapFile. 
+// Input   :  it     - The iterator to drain. 
+//            format - The layout of the data pages. Files other than
+//                     SLOTTED_PAGES can only be read with HeapFileScan,
+//                     so only internal temp files should use them.
+// Output  :  out    - out.file is set to the new HeapFile. 
+// Return  :  OK     - if all records were written. 
+//            FAIL   - otherwise. 
+//-------------------------------------------------------------------- 
+Status JoinMethod::Materialize(Iterator* it, JoinSpec& out, PageFormat format) {
+	Status s;
+	HeapFile *tmpHeap = new HeapFile(NULL, s);
+	if (s != OK) {
+		std::cerr << "Failed to create output heapfile." << std::endl;
+		delete tmpHeap;
+		return FAIL;
+	}
+
+	HeapFileWriter writer(tmpHeap, s, format);
+	if (s != OK || it->Open() != OK) {
+		writer.Close();
+		delete tmpHeap;
+		return FAIL;
+	}
+
+	char *rec;
+	while ((s = it->Next(rec)) == OK) {
+		if (writer.Append(rec, it->GetRecLen()) != OK) {
+			std::cerr << "Failed to insert tuple into output heapfile." << std::endl;
+			s = FAIL;
+			break;
+		}
+	}
+
+	it->Close();
+	if (writer.Close() != OK) {
+		s = FAIL;
+	}
+
+	if (s != DONE) {
+		delete tmpHeap;
+		return FAIL;
+	}
+
+	out.file = tmpHeap;
+	out.numOfRecords = writer.GetNumOfRecords();
+	out.numOfPages = writer.GetNumOfPages();
+	return OK;
+}
+
+
+//--------------------------------------------------------------------
+// JoinMethod::CreateIterator
+//
+// Purpose :  Builds a pipelined iterator over the join of two stored
+//            relations.
+// Input   :  left   - The left relation to join.
+//            right  - The right relation to join.
+// Return  :  The iterator. The caller must delete it.
+//--------------------------------------------------------------------
+Iterator* JoinMethod::CreateIterator(JoinSpec& left, JoinSpec& right) {
+	return Pipeline(new HeapFileIterator(left.file, left.recLen),
+		            new HeapFileIterator(right.file, right.recLen),
+					left, right);
+}
+
+
+//--------------------------------------------------------------------
+// JoinIterator::JoinIterator
+// 
+// Input   :  outer     - The outer input, scanned once. 
+//            inner     - The inner input, which may be reopened. 
+//            outerSpec - Describes the records produced by outer. 
+//            innerSpec - Describes the records produced by inner. 
+//            swapped   - True iff outer is the right relation of the join.
+//-------------------------------------------------------------------- 
+JoinIterator::JoinIterator(Iterator* outer, Iterator* inner, 
+	                       JoinSpec& outerSpec, JoinSpec& innerSpec, bool swapped) {
+	this->outer = outer;
+	this->inner = inner;
+	this->outerSpec = outerSpec;
+	this->innerSpec = innerSpec;
+	this->swapped = swapped;
+	recLen = outerSpec.recLen + innerSpec.recLen;
+	outRec = new char[recLen];
+}
+
+JoinIterator::~JoinIterator() {
+	delete outer;
+	delete inner;
+	delete [] outRec;
+}
+
+//--------------------------------------------------------------------
+// JoinIterator::Join
+// 
+// Purpose :  Concatenates an outer and an inner record in <left, right> 
+//            order into the output buffer. 
+// Return  :  The output buffer. 
+//-------------------------------------------------------------------- 
+char* JoinIterator::Join(char* outerRec, char* innerRec) {
+	if (swapped) 
+		JoinMethod::MakeNewRecord(outRec, innerRec, outerRec, innerSpec, outerSpec);
+	else
+		JoinMethod::MakeNewRecord(outRec, outerRec, innerRec, outerSpec, innerSpec);
+	return outRec;
+}
+
+//--------------------------------------------------------------------
+// JoinIterator::InputFile
+// 
+// Purpose :  Returns a HeapFile holding the records of an input. Methods 
+//            that need random access to an input (index probes, sorting) 
+//            use the file directly when the input is a HeapFile scan, and 
+//            otherwise drain the input into a temporary HeapFile. 
+// Input   :  input - The input iterator. 
+// Output  :  spec  - The spec of input. Its record and page counts are 
+//                    set to those of the returned file. 
+//            tmp   - The temporary HeapFile, or NULL if none was created. 
+//                    The caller must delete it. 
+// Return  :  The HeapFile, or NULL on error. 
+//-------------------------------------------------------------------- 
+HeapFile* JoinIterator::InputFile(Iterator* input, JoinSpec& spec, HeapFile*& tmp) {
+	tmp = NULL;
+	if (input->GetFile() != NULL) {
+		if (spec.file != input->GetFile()) {
+			spec.file = input->GetFile();
+			spec.numOfRecords = -1;
+			spec.numOfPages = -1;
+		}
+		return spec.file;
+	}
+
+	// Only this iterator reads the file, so it can use the denser pages
+	JoinSpec tmpSpec;
+	tmpSpec.recLen = input->GetRecLen();
+	if (JoinMethod::Materialize(input, tmpSpec, FIXED_PAGES) != OK) {
+		return NULL;
+	}
+	tmp = tmpSpec.file;
+	spec.numOfRecords = tmpSpec.numOfRecords;
+	spec.numOfPages = tmpSpec.numOfPages;
+	return tmp;
+}
+
+
+
 //--------------------------------------------------------------------
 // JoinMethod::Execute
 // 
-// Purpose :  Initializes all attributes of the out JoinSpec except the 
-//            file. Individual join implementations should call this method. 
+// Purpose :  Initializes all attributes of the out JoinSpec except the
+//            file, which is set to NULL. Individual join implementations
+//            should call this method.
 // Input   :  left   - The left relation to join. 
 //            right  - The right relation to join. 
 // Output  :  out    - The relation that will hold the join result. 
@@ -194,6 +447,9 @@ HeapFile* JoinMethod::SortHeapFile(HeapFile *file, int len, int offset) {
 //            FAIL   - otherwise. 
 //-------------------------------------------------------------------- 
 Status JoinMethod::Execute(JoinSpec& left, JoinSpec& right, JoinSpec& out) {
+	out.file = NULL;
+	out.numOfRecords = -1;
+	out.numOfPages = -1;
 	out.recLen = left.recLen + right.recLen;
 	out.joinAttr = -1;
 	out.offset = -1;
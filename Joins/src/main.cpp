@@ -22,6 +22,18 @@ void printHelp() {
 		      << std::endl;
 	std::cout << "\ttest 4: Compare SortMerge with TupleNestedLoops."
 		      << std::endl;
+	std::cout << "\ttest 5: Test pipelined join iterators." << std::endl;
+	std::cout << "\ttest 6: Compare BatchNestedLoops with TupleNestedLoops."
+		      << std::endl;
+	std::cout << "\ttest 7: Compare the nested loops joins with TupleNestedLoops"
+		      << " on a relation larger than the buffer pool." << std::endl;
+	std::cout << "bench <empSize> <projSize>: Compares the buffer pool misses"
+		      << " and time of all join methods." << std::endl;
+	std::cout << "packedbench <empSize> <projSize>: Like bench, with both relations"
+		      << " on compressed column-wise pages." << std::endl;
+	std::cout << "stats: Prints the buffer pool statistics of each operator, and"
+		      << " how many probes passed the Bloom filters, since the last stats"
+		      << " command." << std::endl;
 	std::cout << "seed <num>: Seeds the random number generator" << std::endl;
 	std::cout << "quit" << std::endl;
 }